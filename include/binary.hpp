@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace xt {
+    // Fields of the engine's own binary files are little-endian and may be unaligned
+    template <typename T>
+    T ReadLittleEndian(const std::uint8_t *data) {
+        T value = 0;
+        for (std::size_t i = sizeof(T); i-- > 0;)
+            value = static_cast<T>(value << 8 | data[i]);
+        return value;
+    }
+
+    template <typename T>
+    void WriteLittleEndian(std::uint8_t *data, T value) {
+        for (std::size_t i = 0; i < sizeof(T); i++, value >>= 8)
+            data[i] = static_cast<std::uint8_t>(value);
+    }
+
+    // Appends the rest of a scratch file to another, returning false if a write failed
+    bool CopyFile(std::FILE *source, std::FILE *dest);
+} // namespace xt
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 
@@ -19,8 +20,8 @@ namespace xt {
         Int y;
 
     public:
-        Vector(Int x, Int y) : x(x), y(y) { }
-        Vector() : Vector(0, 0) { }
+        constexpr Vector(Int x, Int y) : x(x), y(y) { }
+        constexpr Vector() : Vector(0, 0) { }
 
         Vector &operator+=(const Vector &other) {
             x += other.x;
@@ -57,12 +58,125 @@ namespace xt {
         static constexpr Int INVALID_TEAM{-1};
     };
 
+    struct Move {
+        Vector      src{INVALID_POS};
+        Vector      dest{INVALID_POS};
+        Piece::Type promotion{Piece::MAX};
+
+    public:
+        bool IsValid() const;
+
+        // 6 bits source square, 6 bits destination square, 3 bits promotion. 0 is no move.
+        std::uint16_t Pack() const;
+        static Move   Unpack(std::uint16_t data);
+
+        // Long algebraic notation as used by UCI (ie 'e7e8q')
+        std::string ToString() const;
+
+        bool operator==(const Move &other) const {
+            return src == other.src && dest == other.dest && promotion == other.promotion;
+        }
+
+        bool operator!=(const Move &other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Midgame and endgame halves of an evaluation term, blended by the game phase
+    struct Score {
+        int mg{0};
+        int eg{0};
+
+    public:
+        Score &operator+=(const Score &other) {
+            mg += other.mg;
+            eg += other.eg;
+            return *this;
+        }
+
+        Score &operator-=(const Score &other) {
+            mg -= other.mg;
+            eg -= other.eg;
+            return *this;
+        }
+
+        bool operator==(const Score &other) const {
+            return mg == other.mg && eg == other.eg;
+        }
+
+        bool operator!=(const Score &other) const {
+            return !(*this == other);
+        }
+    };
+
+    // First layer of the evaluation network from each side's point of view, kept up to date by
+    // Board as pieces move. network is the id of the weights it holds sums of, 0 for none.
+    struct Accumulator {
+        static constexpr const int SIZE = 128;
+
+        alignas(32) std::int16_t values[Team::MAX][SIZE];
+        std::uint32_t network{0};
+    };
+
+    class MoveList {
+    public:
+        static constexpr const std::size_t CAPACITY = 256;
+
+    public:
+        void Add(const Move &move) {
+            mMoves[mSize++] = move;
+        }
+
+        void Clear() {
+            mSize = 0;
+        }
+
+        std::size_t Size() const {
+            return mSize;
+        }
+
+        bool Empty() const {
+            return mSize == 0;
+        }
+
+        Move &operator[](std::size_t index) {
+            return mMoves[index];
+        }
+
+        const Move &operator[](std::size_t index) const {
+            return mMoves[index];
+        }
+
+        Move *begin() {
+            return mMoves;
+        }
+
+        Move *end() {
+            return mMoves + mSize;
+        }
+
+        const Move *begin() const {
+            return mMoves;
+        }
+
+        const Move *end() const {
+            return mMoves + mSize;
+        }
+
+    private:
+        Move        mMoves[CAPACITY];
+        std::size_t mSize{0};
+    };
+
     class Board {
     public:
         static constexpr const Int SIZE = 8;
 
         enum Status { ACTIVE, CHECKMATE, STALEMATE };
 
+        static constexpr const char *START_FEN =
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
     public:
         Board();
         void Initialize(const std::vector<std::pair<char, Piece::Type>> &rear);
@@ -85,10 +199,56 @@ namespace xt {
         bool TryMove(const Vector &src, const Vector &dest);
         void Promote(Piece::Type type);
 
+    public:
+        // Engine interface. Moves are always generated and made for the side to move.
+        void GenerateMoves(MoveList &moves) const;
+        void MakeMove(const xt::Move &move);
+        void MakeNullMove();
+
+        std::optional<xt::Move> ParseMove(std::string_view text) const;
+
+        // Standard algebraic notation (ie 'Nbd7', 'exd8=Q+', 'O-O'). Only the pieces that could
+        // reach the destination are generated, rather than every legal move.
+        std::optional<xt::Move> ParseSan(std::string_view text) const;
+
+        // Standard algebraic notation for a legal move, with '+' or '#' after a check or a mate.
+        // Disambiguation only looks at the pieces that could reach the destination.
+        std::string GetSan(const xt::Move &move) const;
+
+        bool InCheck() const;
+        bool IsAttacked(const Vector &pos, Team by) const;
+        bool IsCapture(const xt::Move &move) const;
+        bool HasNonPawnMaterial(Team team) const;
+
+        std::uint64_t GetHash() const;
+        std::uint64_t GetPawnHash() const;
+        int           GetHalfMoves() const;
+        int           GetFullMoves() const;
+        int           GetPieceCount() const;
+
+        // Bits 0 and 1 for white's king and queen side, 2 and 3 for black's
+        std::uint8_t GetCastlingRights() const;
+
+        // The pawn that can be taken en passant by a pawn of the side to move, if any
+        Vector GetEnPassant() const;
+
+        // Material and piece-square sums, white minus black, and the game phase
+        Score GetPieceSquares() const;
+        int   GetPhase() const;
+
+        const Accumulator &GetAccumulator() const;
+
     public:
         std::vector<std::uint8_t> Save() const;
         bool                      Load(const std::vector<std::uint8_t> &data);
 
+        bool        LoadFen(std::string_view fen);
+        std::string GetFen() const;
+
+        // Replace the position with pieces, without castling or en passant rights, for tools that
+        // enumerate positions. Fails if a king is missing.
+        bool Setup(const std::vector<std::pair<Vector, Piece>> &pieces, Team turn);
+
     private:
         // Chess notation (ie 'E4')
         Piece &At(char col, Int row);
@@ -112,9 +272,43 @@ namespace xt {
         // returns position of the rook to castle with if valid
         std::optional<Vector> IsCastlingMove(const Vector &src, const Vector &dest) const;
 
+        // Pseudo-legal moves of the piece on src, filtered for king safety by GenerateMoves
+        void GeneratePieceMoves(const Vector &src, MoveList &moves) const;
+
+        // Squares of pieces of the side to move that could move to dest, looking outwards from it,
+        // limited to a file and rank when they are not -1
+        static constexpr const int MAX_ORIGINS = 16;
+
+        int FindOrigins(Piece::Type  type,
+                        const Vector &dest,
+                        int           file,
+                        int           rank,
+                        Vector (&origins)[MAX_ORIGINS]) const;
+
+        // Whether a pseudo-legal move leaves the king safe
+        bool IsLegal(const xt::Move &move) const;
+        bool HasLegalMove() const;
+
+        // Add or remove the piece on pos from the incrementally updated state
+        void Place(const Vector &pos);
+        void Lift(const Vector &pos);
+
+        void Refresh();
+        void RefreshAccumulator(Team perspective);
+
     private:
-        Piece  mBoard[SIZE * SIZE];
-        Vector mPromoting{INVALID_POS};
-        Team   mTurn{Team::WHITE};
+        Piece         mBoard[SIZE * SIZE];
+        Vector        mPromoting{INVALID_POS};
+        Team          mTurn{Team::WHITE};
+        Vector        mKings[Team::MAX]{INVALID_POS, INVALID_POS};
+        Vector        mEnPassant{INVALID_POS};
+        int           mHalfMoves{0};
+        int           mFullMoves{1};
+        std::uint64_t mHash{0};
+        std::uint64_t mPawnHash{0};
+        Score         mPieceSquares;
+        int           mPhase{0};
+        int           mPieceCount{0};
+        Accumulator   mAccumulator;
     };
 } // namespace xt
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "board.hpp"
+#include "mmap.hpp"
+
+namespace xt {
+    // Opening book in the Polyglot format: 16 byte big endian entries of key, move, weight and
+    // learn value, sorted by key. The file is memory mapped and binary searched in place, so
+    // opening a book of any size costs nothing up front.
+    class Book {
+    public:
+        static constexpr const std::size_t ENTRY_SIZE = 16;
+
+        struct Entry {
+            std::uint64_t key{0};
+            std::uint16_t move{0};
+            std::uint16_t weight{0};
+            std::uint32_t learn{0};
+        };
+
+    public:
+        bool Open(const std::string &path);
+        void Close();
+
+        bool        IsOpen() const;
+        std::size_t GetSize() const;
+
+        // Legal book moves for board with their weights
+        std::vector<std::pair<Move, std::uint16_t>> GetMoves(const Board &board) const;
+
+        // Picks a book move at random in proportion to the weights, if board is in the book
+        std::optional<Move> Pick(const Board &board);
+
+        // Polyglot's key layout: 12 x 64 piece squares, 4 castling rights, the en passant file
+        // and the side to move
+        static std::uint64_t GetKey(const Board &board);
+
+        // Polyglot move encoding, where castling is the king taking its own rook
+        static std::uint16_t       EncodeMove(const Board &board, const Move &move);
+        static std::optional<Move> DecodeMove(const Board &board, std::uint16_t data);
+
+        static Entry ReadEntry(const std::uint8_t *data);
+        static void  WriteEntry(const Entry &entry, std::uint8_t *data);
+
+    private:
+        MappedFile   mFile;
+        std::mt19937 mRandom{std::random_device{}()};
+    };
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "board.hpp"
+#include "pawns.hpp"
+
+namespace xt {
+    constexpr const int PIECE_VALUES[Piece::MAX + 1] = {900, 0, 500, 320, 330, 100, 0};
+
+    // Base score of an ending known to be won, well above any material balance but below mates
+    constexpr const int SCORE_KNOWN_WIN = 10000;
+
+    // Static evaluation in centipawns from the point of view of the side to move. Uses the active
+    // network if there is one, otherwise blends the incrementally updated midgame and endgame
+    // piece-square sums by the game phase.
+    int Evaluate(const Board &board);
+
+    // Same as above, with the pawn structure looked up in pawns
+    int Evaluate(const Board &board, PawnTable &pawns);
+} // namespace xt
\ No newline at end of file
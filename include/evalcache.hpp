@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace xt {
+    // Direct mapped cache of static evaluations by Zobrist hash, owned by one search thread. Each
+    // slot packs the upper 48 bits of the key with the 16 bit score.
+    class EvalCache {
+    public:
+        static constexpr const std::size_t DEFAULT_SIZE = 256; // kilobytes
+
+    public:
+        explicit EvalCache(std::size_t kilobytes = DEFAULT_SIZE);
+
+        // A size of 0 disables the cache
+        void Resize(std::size_t kilobytes);
+        void Clear();
+
+        bool Probe(std::uint64_t key, int &score);
+        void Store(std::uint64_t key, int score);
+
+        void          ResetStats();
+        std::uint64_t GetProbes() const;
+        std::uint64_t GetHits() const;
+
+    private:
+        std::unique_ptr<std::uint64_t[]> mSlots;
+        std::size_t                      mMask{0};
+        std::uint64_t                    mProbes{0};
+        std::uint64_t                    mHits{0};
+    };
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "board.hpp"
+#include "mmap.hpp"
+
+namespace xt {
+    // Games stored for random access straight from a memory mapped file:
+    //   header (64 bytes): MAGIC, VERSION, the game and string counts and the section offsets
+    //   moves: each game's moves, 16 bits each as packed by Move::Pack
+    //   index: ENTRY_SIZE bytes per game, so game N is found without a search
+    //   strings: every distinct tag value once, an offset table followed by the text
+    // Opening maps the file and reads only the header, however many games it holds.
+    class GameDatabase {
+    public:
+        static constexpr const std::uint32_t MAGIC       = 0x44475458; // 'XTGD'
+        static constexpr const std::uint32_t VERSION     = 1;
+        static constexpr const std::size_t   HEADER_SIZE = 64;
+        static constexpr const std::size_t   ENTRY_SIZE  = 48;
+
+        // Tags kept for every game. An empty FEN is the standard starting position.
+        enum Tag { EVENT, SITE, DATE, ROUND, WHITE, BLACK, FEN, TAGS };
+
+        enum Result : std::uint8_t { UNFINISHED, WHITE_WON, BLACK_WON, DRAWN };
+
+        using Tags = std::array<std::string_view, TAGS>;
+
+    public:
+        static const char *GetTagName(Tag tag);
+
+        static Result           ParseResult(std::string_view text);
+        static std::string_view GetResultText(Result result);
+
+        bool Open(const std::string &path);
+        void Close();
+
+        std::size_t GetSize() const;
+
+        std::string_view GetTag(std::size_t game, Tag tag) const;
+        Result           GetResult(std::size_t game) const;
+        std::size_t      GetPlies(std::size_t game) const;
+        Move             GetMove(std::size_t game, std::size_t ply) const;
+
+        // Sets board to the game's starting position
+        bool Setup(std::size_t game, Board &board) const;
+
+        // Replays the game onto board, calling f(board, move) before each move is made until it
+        // returns false. Moves are decoded from the mapped file as they are played.
+        template <typename F>
+        bool Replay(std::size_t game, Board &board, F &&f) const {
+            if (!Setup(game, board))
+                return false;
+
+            const auto plies = GetPlies(game);
+            for (std::size_t ply = 0; ply < plies; ply++) {
+                // A damaged file may hold moves that aren't legal in the position
+                const auto move = GetMove(game, ply);
+                MoveList   moves;
+                board.GenerateMoves(moves);
+                if (std::find(moves.begin(), moves.end(), move) == moves.end())
+                    return false;
+                if (!f(board, move))
+                    break;
+
+                board.MakeMove(move);
+            }
+
+            return true;
+        }
+
+    private:
+        const std::uint8_t *GetEntry(std::size_t game) const;
+
+    private:
+        MappedFile          mFile;
+        std::size_t         mGames{0};
+        std::size_t         mStrings{0};
+        const std::uint8_t *mIndex{nullptr};
+        const std::uint8_t *mOffsets{nullptr};
+    };
+
+    // Writes a game database, one game at a time. Moves go straight to the file and the index to
+    // a scratch file next to it, so only the distinct tag values are held in memory.
+    class GameDatabaseWriter {
+    public:
+        ~GameDatabaseWriter();
+
+        bool Open(const std::string &path);
+
+        // Games added so far
+        std::size_t GetSize() const;
+
+        // Adds a game, returning its number
+        std::size_t Add(const GameDatabase::Tags &tags,
+                        GameDatabase::Result      result,
+                        const std::uint16_t      *moves,
+                        std::size_t               plies);
+
+        // Writes the index, strings and header, and closes the file
+        bool Close();
+
+    private:
+        std::uint32_t GetString(std::string_view text);
+
+    private:
+        std::string                                    mPath;
+        std::FILE                                     *mFile{nullptr};
+        std::FILE                                     *mIndex{nullptr};
+        std::uint64_t                                  mOffset{0};
+        std::size_t                                    mGames{0};
+        std::unordered_map<std::string, std::uint32_t> mStringIds;
+        std::vector<std::string_view>                  mStrings;
+        std::vector<std::uint8_t>                      mMoves;
+        bool                                           mFailed{false};
+    };
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "board.hpp"
+
+namespace xt {
+    // King and pawn versus king win/draw bitbase, one bit for every position with the pawn on
+    // files a-d (24 KB). It is built by retrograde analysis the first time it is probed.
+    class Kpk {
+    public:
+        // board must hold nothing but the two kings and the pawn on pawn, which can't be on the
+        // first or last rank. Returns true if the side with the pawn wins, and false for a draw.
+        static bool Probe(const Board &board, const Vector &pawn);
+
+        // Builds the bitbase now rather than on the first probe
+        static void Initialize();
+    };
+} // namespace xt
\ No newline at end of file
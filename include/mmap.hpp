@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace xt {
+    // Read-only memory mapping of a whole file. Pages are loaded by the OS on first touch and
+    // shared between processes mapping the same file.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        MappedFile(const MappedFile &)            = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool Open(const std::string &path);
+        void Close();
+
+        bool                IsOpen() const;
+        const std::uint8_t *GetData() const;
+        std::size_t         GetSize() const;
+
+    private:
+        const std::uint8_t *mData{nullptr};
+        std::size_t         mSize{0};
+    };
+} // namespace xt
\ No newline at end of file
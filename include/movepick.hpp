@@ -0,0 +1,59 @@
+#pragma once
+
+#include "board.hpp"
+
+namespace xt {
+    // Butterfly history: how often a quiet move from one square to another caused a cutoff
+    using History = int[Board::SIZE * Board::SIZE][Board::SIZE * Board::SIZE];
+
+    constexpr const int HISTORY_MAX = 16384;
+
+    // Hands out moves one at a time in the order most likely to produce an early cutoff: the hash
+    // move, then captures by most valuable victim / least valuable attacker, then the killers of
+    // this ply, then the remaining quiet moves by history. Captures that lose material by static
+    // exchange are held back until last. Each stage is only sorted when reached.
+    class MovePicker {
+    public:
+        enum Stage { HASH, CAPTURES, KILLERS, QUIETS, BAD_CAPTURES, DONE };
+
+    public:
+        MovePicker(const Board   &board,
+                   const Move    &hashMove,
+                   const Move   (&killers)[2],
+                   const History &history);
+
+        // Quiescence: only captures and promotions that don't lose material, unless the side to
+        // move is in check, in which case every evasion is returned
+        MovePicker(const Board &board, const History &history);
+
+        // Returns an invalid move once every legal move has been picked
+        Move  Next();
+        Stage GetStage() const;
+
+        std::size_t GetMoveCount() const;
+        bool        IsTactical(const Move &move) const;
+
+    private:
+        void Score();
+
+        // Selection sort step over [mCurrent, end) by score
+        Move PickBest(std::size_t end);
+
+    private:
+        const Board   &mBoard;
+        const History &mHistory;
+
+        Move  mHashMove;
+        Move  mKillers[2];
+        Stage mStage{Stage::HASH};
+        bool  mQuiescence{false};
+
+        MoveList    mMoves;
+        MoveList    mBadCaptures;
+        int         mScores[MoveList::CAPACITY];
+        std::size_t mCurrent{0};
+        std::size_t mQuiets{0};
+        std::size_t mKiller{0};
+        std::size_t mBadCapture{0};
+    };
+} // namespace xt
\ No newline at end of file
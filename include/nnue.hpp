@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "mmap.hpp"
+
+namespace xt {
+    // Efficiently updatable network with HalfKP-like inputs: one feature per (own king square,
+    // piece, square) triple from each side's point of view. The first layer lives in the Board's
+    // Accumulator and is updated as pieces move, so only the small dense layers run per eval.
+    //
+    // File layout, little endian, every block a multiple of 64 bytes so the mapping stays aligned:
+    //   header (64 bytes, starting with MAGIC, VERSION and the dimensions below)
+    //   int16 feature biases[Accumulator::SIZE], int16 feature weights[FEATURES][Accumulator::SIZE]
+    //   int32 hidden1 biases[HIDDEN], int8 hidden1 weights[HIDDEN][2 * Accumulator::SIZE]
+    //   int32 hidden2 biases[HIDDEN], int8 hidden2 weights[HIDDEN][HIDDEN]
+    //   int32 output bias (padded to 64 bytes), int8 output weights[HIDDEN] (padded to 64 bytes)
+    class Network {
+    public:
+        static constexpr const std::uint32_t MAGIC   = 0x4E4E5458; // 'XTNN'
+        static constexpr const std::uint32_t VERSION = 1;
+
+        static constexpr const int SQUARES  = Board::SIZE * Board::SIZE;
+        static constexpr const int FEATURES = SQUARES * 10 * SQUARES;
+        static constexpr const int HIDDEN   = 32;
+
+        enum Isa : std::uint8_t { SCALAR, SSE41, AVX2, ISA_MAX };
+
+    public:
+        // Maps a network file, returning nullptr if it is missing or malformed
+        static std::unique_ptr<Network> Load(const std::string &path);
+
+        // Deterministic random weights, only good for measuring speed
+        static std::unique_ptr<Network> CreateRandom(std::uint64_t seed);
+
+        // The network used by Evaluate, or nullptr for the hand written evaluation. Boards only
+        // keep their accumulators up to date for the active network.
+        static const Network *GetActive();
+        static void           SetActive(std::unique_ptr<Network> network);
+
+        static bool        IsSupported(Isa isa);
+        static const char *GetName(Isa isa);
+
+        static int GetFeature(Team perspective, const Vector &king, const Piece &piece,
+                              const Vector &pos);
+
+    public:
+        std::uint32_t GetId() const;
+
+        // Kernels used by Evaluate, the best the CPU supports by default
+        Isa  GetIsa() const;
+        void SetIsa(Isa isa);
+
+        void Refresh(const Board &board, Team perspective, Accumulator &accumulator) const;
+        void AddFeature(Accumulator &accumulator, Team perspective, int feature) const;
+        void RemoveFeature(Accumulator &accumulator, Team perspective, int feature) const;
+
+        // In centipawns from the point of view of the side to move
+        int Evaluate(const Board &board) const;
+        int Evaluate(const Accumulator &accumulator, Team us, Isa isa) const;
+
+    private:
+        Network() = default;
+
+        bool Bind(const std::uint8_t *data, std::size_t size);
+
+    private:
+        MappedFile                mFile;
+        std::vector<std::uint8_t> mOwned;
+        std::uint32_t             mId{0};
+        Isa                       mIsa{SCALAR};
+
+        const std::int16_t *mFeatureBiases{nullptr};
+        const std::int16_t *mFeatureWeights{nullptr};
+        const std::int32_t *mHidden1Biases{nullptr};
+        const std::int8_t  *mHidden1Weights{nullptr};
+        const std::int32_t *mHidden2Biases{nullptr};
+        const std::int8_t  *mHidden2Weights{nullptr};
+        const std::int32_t *mOutputBias{nullptr};
+        const std::int8_t  *mOutputWeights{nullptr};
+    };
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "board.hpp"
+
+namespace xt {
+    // Pawn structure only depends on the pawns, so its terms are cached by the pawn-only hash
+    // kept by Board. Every search thread owns its own table, so no synchronisation is needed.
+    class PawnTable {
+    public:
+        struct Entry {
+            std::uint64_t key{0};
+
+            // Passed, doubled, isolated and backward pawns, white minus black
+            Score score;
+
+            // Midgame bonus of the pawns in front of a king on its first two ranks, by king file
+            std::int16_t shelter[Team::MAX][Board::SIZE]{};
+        };
+
+        static constexpr const std::size_t SIZE = 1 << 14;
+
+    public:
+        PawnTable();
+
+        const Entry &Probe(const Board &board);
+        void         ResetStats();
+
+        std::uint64_t GetProbes() const;
+        std::uint64_t GetHits() const;
+
+        // Evaluates the pawn structure from scratch
+        static void Compute(const Board &board, Entry &entry);
+
+    private:
+        std::unique_ptr<Entry[]> mEntries;
+        std::uint64_t            mProbes{0};
+        std::uint64_t            mHits{0};
+    };
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "board.hpp"
+#include "mmap.hpp"
+
+namespace xt {
+    // One game of a PGN text. Everything is a view into the text, which must outlive the game,
+    // and a game can be reused for the next one without allocating.
+    class PgnGame {
+    public:
+        static constexpr const std::size_t MAX_TAGS = 32;
+
+        struct Tag {
+            std::string_view name;
+            std::string_view value; // as written, escapes included
+        };
+
+    public:
+        std::string_view GetText() const;
+        std::string_view GetMovetext() const;
+
+        std::size_t      GetTagCount() const;
+        const Tag       &GetTag(std::size_t index) const;
+        std::string_view GetTag(std::string_view name) const;
+
+        // The Result tag, or the result that ends the movetext if there is none
+        std::string_view GetResult() const;
+
+        // Next move of the main line after pos in the movetext, skipping move numbers, comments,
+        // variations and annotations. Empty at the end of the game.
+        std::string_view NextMove(std::size_t &pos) const;
+
+        // Sets board to the starting position, from the FEN tag if there is one
+        bool Setup(Board &board) const;
+
+        // Replays the main line onto board, calling f(board, move) before each move is made until
+        // it returns false. Fails on a bad FEN tag or a move that isn't legal.
+        template <typename F>
+        bool Replay(Board &board, F &&f) const {
+            if (!Setup(board))
+                return false;
+
+            for (std::size_t pos = 0;;) {
+                const auto text = NextMove(pos);
+                if (text.empty())
+                    return true;
+
+                const auto move = board.ParseSan(text);
+                if (!move)
+                    return false;
+                if (!f(board, *move))
+                    return true;
+
+                board.MakeMove(*move);
+            }
+        }
+
+    private:
+        friend class PgnReader;
+
+        std::string_view mText;
+        std::string_view mMovetext;
+        Tag              mTags[MAX_TAGS];
+        std::size_t      mTagCount{0};
+    };
+
+    // Splits a PGN text into games without copying it. Files are memory mapped, and a reader can
+    // also work through part of a text so that several threads can share one file.
+    class PgnReader {
+    public:
+        PgnReader() = default;
+        explicit PgnReader(std::string_view text);
+
+        bool Open(const std::string &path);
+
+        std::string_view GetText() const;
+        std::size_t      GetPosition() const;
+
+        // Moves to the first game starting at or after pos
+        void Seek(std::size_t pos);
+
+        bool Next(PgnGame &game);
+
+        // Games start at a tag line that doesn't follow another. Returns the first start at or
+        // after pos, so readers given neighbouring ranges of a text agree on where one ends.
+        static std::size_t FindGame(std::string_view text, std::size_t pos);
+
+    private:
+        MappedFile       mFile;
+        std::string_view mText;
+        std::size_t      mPos{0};
+    };
+
+    // Records the moves of a game in SAN as they are played, and writes the game out as PGN. The
+    // buffers are kept from one game to the next, so recording many games allocates little.
+    class GameRecorder {
+    public:
+        // Starts a new game from board, forgetting the moves and tags of the last one
+        void Reset(const Board &board);
+
+        // Records move, which must be legal, as played from board. Play also makes it.
+        void Add(const Board &board, const Move &move);
+        void Play(Board &board, const Move &move);
+
+        // The seven tag roster is always written, with '?' for anything not set
+        void SetTag(std::string_view name, std::string_view value);
+        void SetResult(std::string_view result);
+
+        const std::vector<Move> &GetMoves() const;
+
+        // Appends the game to out, with the movetext wrapped before 80 columns
+        void Write(std::string &out) const;
+
+    private:
+        std::string_view GetTag(std::string_view name) const;
+
+    private:
+        std::string                                      mFen; // empty for the standard start
+        Team                                             mTurn{Team::WHITE};
+        int                                              mFullMoves{1};
+        std::vector<Move>                                mMoves;
+        std::string                                      mSan; // moves separated by spaces
+        std::vector<std::pair<std::string, std::string>> mTags;
+        std::string                                      mResult{"*"};
+    };
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "pgn.hpp"
+
+namespace xt {
+    // Queue between two pipeline stages. Push blocks while it is full, so a slow stage holds back
+    // the ones feeding it rather than letting work pile up in memory.
+    template <typename T>
+    class BoundedQueue {
+    public:
+        using Duration = std::chrono::steady_clock::duration;
+
+    public:
+        explicit BoundedQueue(std::size_t capacity) : mCapacity(capacity) { }
+
+        void Push(T item) {
+            std::unique_lock lock{mMutex};
+            if (mItems.size() >= mCapacity) {
+                const auto start = std::chrono::steady_clock::now();
+                mNotFull.wait(lock, [&] { return mItems.size() < mCapacity; });
+                mPushWait += std::chrono::steady_clock::now() - start;
+            }
+
+            mItems.push_back(std::move(item));
+            mNotEmpty.notify_one();
+        }
+
+        // Blocks until there is an item, or returns nothing once the queue is closed and empty
+        std::optional<T> Pop() {
+            std::unique_lock lock{mMutex};
+            if (mItems.empty() && !mClosed) {
+                const auto start = std::chrono::steady_clock::now();
+                mNotEmpty.wait(lock, [&] { return !mItems.empty() || mClosed; });
+                mPopWait += std::chrono::steady_clock::now() - start;
+            }
+
+            if (mItems.empty())
+                return std::nullopt;
+
+            auto item = std::move(mItems.front());
+            mItems.pop_front();
+            mNotFull.notify_one();
+            return item;
+        }
+
+        void Close() {
+            std::lock_guard lock{mMutex};
+            mClosed = true;
+            mNotEmpty.notify_all();
+        }
+
+        // Time spent blocked, summed over every thread
+        Duration GetPushWait() const {
+            std::lock_guard lock{mMutex};
+            return mPushWait;
+        }
+
+        Duration GetPopWait() const {
+            std::lock_guard lock{mMutex};
+            return mPopWait;
+        }
+
+    private:
+        mutable std::mutex      mMutex;
+        std::condition_variable mNotFull;
+        std::condition_variable mNotEmpty;
+        std::deque<T>           mItems;
+        std::size_t             mCapacity;
+        bool                    mClosed{false};
+        Duration                mPushWait{};
+        Duration                mPopWait{};
+    };
+
+    // Work done by one pipeline stage. Busy and waiting times are summed over its threads.
+    struct StageStats {
+        std::size_t                         items{0};
+        std::size_t                         bytes{0};
+        std::chrono::steady_clock::duration busy{};
+        std::chrono::steady_clock::duration waiting{};
+    };
+
+    struct PipelineStats {
+        StageStats                          reader;
+        StageStats                          workers;
+        StageStats                          sink;
+        std::chrono::steady_clock::duration elapsed{};
+    };
+
+    // Runs a PGN text through three stages: a reader cutting it into batches of whole games, a
+    // pool of workers turning each batch into a Result, and a sink that is handed the results in
+    // the order of the text. The queues are bounded and the reader never gets more than a fixed
+    // number of batches ahead of the sink, so memory stays flat however large the text is.
+    template <typename Result>
+    class PgnPipeline {
+    public:
+        using Work = std::function<Result(std::string_view text)>;
+        using Sink = std::function<void(Result &&result)>;
+
+    public:
+        explicit PgnPipeline(std::size_t threads,
+                             std::size_t batchSize = std::size_t{1} << 20,
+                             std::size_t queueSize = 16)
+            : mThreads(std::max<std::size_t>(threads, 1)),
+              mBatchSize(std::max<std::size_t>(batchSize, 1)),
+              mQueueSize(std::max<std::size_t>(queueSize, 1)) { }
+
+        PipelineStats Run(std::string_view text, const Work &work, const Sink &sink) const {
+            using Clock = std::chrono::steady_clock;
+
+            struct Batch {
+                std::size_t      index;
+                std::string_view text;
+            };
+
+            const auto                                   start = Clock::now();
+            const std::size_t                            window = mQueueSize * 2 + mThreads;
+            BoundedQueue<Batch>                          input{mQueueSize};
+            BoundedQueue<std::pair<std::size_t, Result>> output{mQueueSize};
+            PipelineStats                                stats;
+
+            // Batches handed to the sink, which the reader may run ahead of by up to window
+            std::mutex              mutex;
+            std::condition_variable emitted;
+            std::size_t             done = 0;
+
+            std::thread reader([&] {
+                std::size_t index = 0;
+                for (auto pos = PgnReader::FindGame(text, 0); pos < text.size(); index++) {
+                    auto       now = Clock::now();
+                    const auto end = PgnReader::FindGame(text, pos + mBatchSize);
+                    stats.reader.busy += Clock::now() - now;
+
+                    now = Clock::now();
+                    {
+                        std::unique_lock lock{mutex};
+                        emitted.wait(lock, [&] { return index < done + window; });
+                    }
+                    stats.reader.waiting += Clock::now() - now;
+
+                    input.Push({index, text.substr(pos, end - pos)});
+                    stats.reader.items++;
+                    stats.reader.bytes += end - pos;
+                    pos = end;
+                }
+
+                input.Close();
+            });
+
+            std::mutex               statsMutex;
+            std::atomic<std::size_t> running{mThreads};
+            std::vector<std::thread> workers;
+            for (std::size_t i = 0; i < mThreads; i++) {
+                workers.emplace_back([&] {
+                    StageStats local;
+                    while (auto batch = input.Pop()) {
+                        const auto now    = Clock::now();
+                        auto       result = work(batch->text);
+                        local.busy += Clock::now() - now;
+                        local.items++;
+                        local.bytes += batch->text.size();
+
+                        output.Push({batch->index, std::move(result)});
+                    }
+
+                    {
+                        std::lock_guard lock{statsMutex};
+                        stats.workers.items += local.items;
+                        stats.workers.bytes += local.bytes;
+                        stats.workers.busy += local.busy;
+                    }
+
+                    if (--running == 0)
+                        output.Close();
+                });
+            }
+
+            // Results can arrive out of order, and wait here until the ones before them are in
+            std::map<std::size_t, Result> pending;
+            while (auto item = output.Pop()) {
+                pending.emplace(std::move(*item));
+                for (auto it = pending.begin(); it != pending.end() && it->first == done;) {
+                    const auto now = Clock::now();
+                    sink(std::move(it->second));
+                    stats.sink.busy += Clock::now() - now;
+                    stats.sink.items++;
+                    it = pending.erase(it);
+
+                    std::lock_guard lock{mutex};
+                    done++;
+                    emitted.notify_one();
+                }
+            }
+
+            reader.join();
+            for (auto &worker : workers)
+                worker.join();
+
+            stats.reader.waiting += input.GetPushWait();
+            stats.workers.waiting = input.GetPopWait() + output.GetPushWait();
+            stats.sink.waiting    = output.GetPopWait();
+            stats.sink.bytes      = stats.workers.bytes;
+            stats.elapsed         = Clock::now() - start;
+            return stats;
+        }
+
+    private:
+        std::size_t mThreads;
+        std::size_t mBatchSize;
+        std::size_t mQueueSize;
+    };
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mmap.hpp"
+
+namespace xt {
+    // Finds the games of a GameDatabase that pass through a position, by its Board::GetHash:
+    //   header (64 bytes): MAGIC, VERSION, the number of positions and where the keys start
+    //   postings: for each position, the games reaching it in order, as varints of the game's
+    //     distance from the one before and the first ply at which it reaches the position
+    //   keys: (key, offset of its postings) for every position in key order, and one more entry
+    //     holding the end of the last postings
+    // A lookup is a binary search of the mapped keys.
+    class PositionIndex {
+    public:
+        static constexpr const std::uint32_t MAGIC       = 0x49505458; // 'XTPI'
+        static constexpr const std::uint32_t VERSION     = 1;
+        static constexpr const std::size_t   HEADER_SIZE = 64;
+
+        struct Posting {
+            std::uint64_t game;
+            std::uint32_t ply; // 0 before the first move
+        };
+
+    public:
+        bool Open(const std::string &path);
+        void Close();
+
+        // Distinct positions in the index
+        std::size_t GetSize() const;
+
+        // Appends the games reaching the position, in game order, and returns how many there were
+        std::size_t Find(std::uint64_t key, std::vector<Posting> &postings) const;
+
+    private:
+        MappedFile          mFile;
+        std::size_t         mKeys{0};
+        const std::uint8_t *mTable{nullptr};
+    };
+
+    // Builds a PositionIndex from positions added in any order. They are sorted in memory, and
+    // once they outgrow the memory budget spilled to disk as sorted runs that Close merges. The
+    // keys go to a scratch file next to the index until the postings are all written.
+    class PositionIndexWriter {
+    public:
+        explicit PositionIndexWriter(std::size_t memory = std::size_t{256} << 20);
+        ~PositionIndexWriter();
+
+        bool Open(const std::string &path);
+
+        void Add(std::uint64_t key, std::uint64_t game, std::uint32_t ply);
+
+        // Merges the runs, writes the postings, keys and header, and closes the file
+        bool Close();
+
+    private:
+        struct Record {
+            std::uint64_t key;
+            std::uint64_t game;
+            std::uint32_t ply;
+
+        public:
+            bool operator<(const Record &other) const;
+        };
+
+        class RunReader;
+
+        bool Spill();
+        void Emit(const Record &record);
+
+    private:
+        std::string                               mPath;
+        std::FILE                                *mFile{nullptr};
+        std::FILE                                *mRuns{nullptr};
+        std::FILE                                *mKeys{nullptr};
+        std::vector<std::pair<long, std::size_t>> mRunOffsets;
+        std::vector<Record>                       mRecords;
+        std::size_t                               mLimit;
+        std::vector<std::uint8_t>                 mBuffer; // postings not yet written
+        Record                                    mLast{};
+        std::uint64_t                             mOffset{0};
+        std::uint64_t                             mCount{0};
+        bool                                      mFailed{false};
+    };
+} // namespace xt
\ No newline at end of file
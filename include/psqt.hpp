@@ -0,0 +1,16 @@
+#pragma once
+
+#include "board.hpp"
+
+namespace xt {
+    // Non-pawn material weights of the game phase, which is PHASE_MAX with every piece on the board
+    constexpr const int PHASE_WEIGHTS[Piece::MAX + 1] = {4, 0, 2, 1, 1, 0, 0};
+    constexpr const int PHASE_MAX                     = 24;
+
+    // Material plus square bonus of each piece, from the point of view of its own team
+    const Score &GetPieceSquare(Team team, Piece::Type type, int square);
+
+    // From-scratch sums of what Board keeps up to date incrementally, white minus black
+    Score ComputePieceSquares(const Board &board);
+    int   ComputePhase(const Board &board);
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "board.hpp"
+#include "evalcache.hpp"
+#include "tablebase.hpp"
+#include "timeman.hpp"
+#include "tt.hpp"
+
+namespace xt {
+    constexpr const int MAX_PLY = 128;
+
+    constexpr const int SCORE_INFINITE    = 32001;
+    constexpr const int SCORE_MATE        = 32000;
+    constexpr const int SCORE_MATE_IN_MAX = SCORE_MATE - MAX_PLY;
+
+    // Selectivity switches, each exposed as a UCI option so its effect can be measured alone
+    struct SearchOptions {
+        bool nullMove{true};
+        bool lateMoveReductions{true};
+        bool futility{true};
+        bool reverseFutility{true};
+
+        // Number of best root moves to search and report, each with its own line
+        std::size_t multiPV{1};
+
+        // Endgame tables are probed below the root with at most tablebaseLimit pieces on the
+        // board, and at full count only from tablebaseDepth up
+        int         tablebaseDepth{1};
+        std::size_t tablebaseLimit{EndgameTable::MAX_PIECES};
+    };
+
+    struct SearchStats {
+        std::uint64_t cutoffs{0};
+        std::uint64_t firstMoveCutoffs{0};
+        std::uint64_t nullMoveCutoffs{0};
+        std::uint64_t reductions{0};
+        std::uint64_t futilityPrunes{0};
+        std::uint64_t reverseFutilityPrunes{0};
+        std::uint64_t pvsResearches{0};
+        std::uint64_t aspirationResearches{0};
+        std::uint64_t pawnProbes{0};
+        std::uint64_t pawnHits{0};
+        std::uint64_t evalProbes{0};
+        std::uint64_t evalHits{0};
+        std::uint64_t tablebaseHits{0};
+
+    public:
+        SearchStats &operator+=(const SearchStats &other);
+
+        // Percentage of beta cutoffs produced by the first move searched
+        double GetFirstMoveCutoffRate() const;
+        double GetPawnHitRate() const;
+        double GetEvalHitRate() const;
+    };
+
+    struct SearchInfo {
+        int                       depth;
+        std::size_t               line; // 1 based MultiPV index
+        int                       score;
+        std::uint64_t             nodes;
+        std::chrono::milliseconds time;
+        int                       hashfull;
+        std::vector<Move>         pv;
+        SearchStats               stats;
+    };
+
+    // Lazy SMP: every thread searches the same root with its own depth offset, and the threads
+    // only cooperate through the shared transposition table.
+    class Search {
+    public:
+        using InfoCallback     = std::function<void(const SearchInfo &)>;
+        // The ponder move is the expected reply, and may be invalid if none is known
+        using BestMoveCallback = std::function<void(const Move &best, const Move &ponder)>;
+
+    public:
+        Search();
+        ~Search();
+
+        void SetThreads(std::size_t threads);
+        void SetHashSize(std::size_t megabytes);
+        void SetEvalCacheSize(std::size_t kilobytes);
+
+        // Maps the endgame tables in directory, or drops them for an empty path. Returns how many
+        // were found.
+        std::size_t SetTablebasePath(const std::string &directory);
+        void SetOptions(const SearchOptions &options);
+        void SetInfoCallback(InfoCallback callback);
+        void SetBestMoveCallback(BestMoveCallback callback);
+
+        // Forget everything learned from previous games
+        void Clear();
+
+        // history holds the hashes of the positions leading up to board, for repetition detection
+        void Start(const Board                      &board,
+                   const std::vector<std::uint64_t> &history,
+                   const SearchLimits               &limits);
+        void Stop();
+        void Wait();
+
+        // The opponent played the move a ponder search expected, so the clock now applies
+        void PonderHit();
+
+        bool                 IsSearching() const;
+        std::size_t          GetThreads() const;
+        const SearchOptions &GetOptions() const;
+        std::uint64_t        GetNodes() const;
+        Move                 GetBestMove() const;
+        Move                 GetPonderMove() const;
+
+        // Totals over every thread, only meaningful once the search has finished
+        SearchStats GetStats() const;
+
+    private:
+        struct Worker;
+
+        // Only ever changed with exchange or compare_exchange, so the main thread deferring its
+        // stop and PonderHit can't miss each other
+        enum PonderState { THINKING, PONDERING, STOP_ON_PONDER_HIT };
+
+        void Run();
+        bool ShouldStop() const;
+
+        // Restricts the root to the moves that keep its tablebase value under the fifty-move rule,
+        // if it has one
+        void ProbeRoot(const MoveList &moves);
+
+    private:
+        TranspositionTable                   mTable;
+        Tablebase                            mTablebase;
+        std::size_t                          mEvalCacheSize{EvalCache::DEFAULT_SIZE};
+        std::vector<std::unique_ptr<Worker>> mWorkers;
+        std::thread                          mThread;
+
+        std::atomic<bool>          mStop{false};
+        std::atomic<bool>          mSearching{false};
+        std::atomic<PonderState>   mPonder{THINKING};
+        std::atomic<std::uint64_t> mNodeCount{0}; // only kept with a node limit
+
+        Board                                 mRoot;
+        std::vector<std::uint64_t>            mHistory;
+        SearchLimits                          mLimits;
+        SearchOptions                         mOptions;
+        TimeManager                           mTime;
+        Move                                  mBestMove;
+        Move                                  mPonderMove;
+
+        // With the root in the endgame tables, the moves that keep its value. Empty otherwise.
+        MoveList mTablebaseMoves;
+
+        InfoCallback     mInfoCallback;
+        BestMoveCallback mBestMoveCallback;
+    };
+} // namespace xt
\ No newline at end of file
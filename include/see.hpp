@@ -0,0 +1,9 @@
+#pragma once
+
+#include "board.hpp"
+
+namespace xt {
+    // Static exchange evaluation: the material balance in centipawns, from the mover's point of
+    // view, after the best sequence of recaptures on the destination square. Pins are ignored.
+    int StaticExchange(const Board &board, const Move &move);
+} // namespace xt
\ No newline at end of file
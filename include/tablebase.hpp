@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "board.hpp"
+#include "mmap.hpp"
+
+namespace xt {
+    // Pieces besides the kings, strongest first on each side
+    struct TableMaterial {
+        std::vector<Piece::Type> pieces[Team::MAX];
+
+    public:
+        // Names look like 'KQvKR', white's pieces before the 'v'
+        static bool Parse(const std::string &name, TableMaterial &material);
+
+        std::string GetName() const;
+        std::size_t GetCount() const;
+        std::size_t GetPawns() const;
+
+        // 4 bits per piece type and team, as computed from a board by Tablebase
+        std::uint64_t GetKey() const;
+
+        void Sort();
+
+        // Tables are stored with white as the stronger side
+        bool          IsCanonical() const;
+        TableMaterial Flipped() const;
+
+        // Materials reachable by a capture or a promotion, other than the bare kings
+        std::vector<TableMaterial> GetConversions() const;
+    };
+
+    // Distance to mate and distance to zeroing table for one material, as written by tbgen. The
+    // file is a 64 byte header followed by one byte per index: the distance to mate in plies plus
+    // one, odd when the side to move loses and even when it wins, or 0 for a draw. A second
+    // section of one byte per index holds the distance to the next capture, pawn move or mate
+    // the same way, which is what decides whether a win beats the fifty-move rule. A zeroing move
+    // by the losing side counts as two plies, so that distance is never understated.
+    //
+    // Positions are indexed by side to move, white king, black king and the remaining pieces in
+    // material order. The white king is mirrored onto files a-d, and without pawns further onto
+    // the a1-d1-d4 triangle. En passant and castling rights are ignored.
+    class EndgameTable {
+    public:
+        static constexpr const std::size_t MAX_PIECES = 4;
+
+        static constexpr const std::uint8_t DRAW   = 0;
+        static constexpr const std::uint8_t BROKEN = 0xFF; // illegal position
+
+        using Squares = std::array<int, MAX_PIECES>;
+
+    public:
+        explicit EndgameTable(const TableMaterial &material);
+
+        static bool IsWin(std::uint8_t value);
+        static bool IsLoss(std::uint8_t value);
+
+        // Value of the position before a move, given the value of the position after it
+        static std::uint8_t GetParent(std::uint8_t child);
+
+        // Orders values from the point of view of the side to move, higher is better
+        static int GetRank(std::uint8_t value);
+
+        const TableMaterial      &GetMaterial() const;
+        const std::vector<Piece> &GetPieces() const;
+        std::size_t               GetSize() const;
+
+        std::size_t Encode(Team turn, Squares squares) const;
+        Team        Decode(std::size_t index, Squares &squares) const;
+
+        // Calls f with every index holding the position. Without pawns, a white king on the a1-h8
+        // diagonal leaves the position and its reflection in that diagonal with separate indices.
+        template <typename F>
+        void ForEachIndex(Team turn, Squares squares, F &&f) const {
+            Normalize(squares);
+            f(GetIndex(turn, squares));
+
+            if (!mPawns && 7 - (squares[0] >> 3) == (squares[0] & 7)) {
+                Transform(squares, Transpose);
+                f(GetIndex(turn, squares));
+            }
+        }
+
+        // Index of board, which must hold this table's material, or its colours swapped if flip
+        std::size_t  Locate(const Board &board, bool flip) const;
+        std::uint8_t Probe(const Board &board, bool flip) const;
+        std::uint8_t Get(std::size_t index) const;
+        std::uint8_t GetDtz(std::size_t index) const;
+
+        // Writable storage for building the table
+        void          Allocate();
+        std::uint8_t *GetValues();
+        std::uint8_t *GetDtzValues();
+
+        bool Open(const std::string &path);
+        bool Save(const std::string &path) const;
+
+    private:
+        static int Transpose(int sq);
+
+        void        Transform(Squares &squares, int (*f)(int)) const;
+        void        Normalize(Squares &squares) const;
+        std::size_t GetIndex(Team turn, const Squares &squares) const;
+        std::size_t GetKingSquares() const;
+        std::size_t GetKingIndex(int sq) const;
+        int         GetKingSquare(std::size_t index) const;
+
+    private:
+        TableMaterial             mMaterial;
+        bool                      mPawns;
+        std::vector<Piece>        mPieces;
+        std::size_t               mSize;
+        std::vector<std::uint8_t> mValues;
+        MappedFile                mFile;
+        const std::uint8_t       *mData{nullptr};
+    };
+
+    // The tables found in a directory, looked up by the material on the board. Files are mapped
+    // rather than read, so opening is instant and only probed pages are ever loaded. Only tables
+    // written by tbgen are read, not Syzygy files.
+    class Tablebase {
+    public:
+        // Maps every table in directory, returning how many were found
+        std::size_t Open(const std::string &directory);
+        void        Close();
+
+        // Syzygy WDL and DTZ files in directory, which Open passes over
+        static std::size_t CountSyzygyFiles(const std::string &directory);
+
+        void                Add(std::unique_ptr<EndgameTable> table);
+        const EndgameTable *Find(const TableMaterial &material) const;
+
+        // Most pieces of any table, 0 if there are none
+        std::size_t GetMaxPieces() const;
+
+        // Value of board for the side to move, if a table holds its material. The bare kings are
+        // always a draw.
+        std::optional<std::uint8_t> Probe(const Board &board) const;
+
+        // Distance to zeroing of board, with the same encoding as Probe
+        std::optional<std::uint8_t> ProbeDtz(const Board &board) const;
+
+    private:
+        // Keyed by material as seen from either side, with whether the colours must be swapped
+        std::unordered_map<std::uint64_t, std::pair<const EndgameTable *, bool>> mIndex;
+        std::vector<std::unique_ptr<EndgameTable>>                              mTables;
+        std::size_t                                                             mMaxPieces{0};
+    };
+} // namespace xt
\ No newline at end of file
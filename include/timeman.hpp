@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "board.hpp"
+
+namespace xt {
+    struct SearchLimits {
+        int                       depth{0}; // 0 for no limit
+        std::uint64_t             nodes{0};
+        std::chrono::milliseconds movetime{0};
+        bool                      infinite{false};
+
+        // Search the expected reply without a deadline until Search::PonderHit
+        bool ponder{false};
+
+        // Clock state as sent by the GUI, a movestogo of 0 meaning sudden death
+        std::chrono::milliseconds time[Team::MAX]{};
+        std::chrono::milliseconds increment[Team::MAX]{};
+        int                       movestogo{0};
+
+    public:
+        bool HasClock() const;
+    };
+
+    // Decides how long a search may run. The soft deadline is checked between iterations and
+    // stretched or shrunk by how stable the best move has been; the hard deadline is checked
+    // every CHECK_INTERVAL nodes from inside the search. A movetime is a fixed budget, so both
+    // deadlines are the same and stability is ignored. Node limits are counted by the search.
+    class TimeManager {
+    public:
+        static constexpr const std::uint64_t CHECK_INTERVAL = 2048;
+
+        // Time kept in reserve for communication with the GUI
+        static constexpr const std::chrono::milliseconds MOVE_OVERHEAD{30};
+
+    public:
+        void Start(const SearchLimits &limits, Team us, std::size_t legalMoves);
+
+        // Returns true if another iteration should not be started
+        bool OnIteration(int depth, const Move &best, int score);
+        bool IsHardLimitReached() const;
+
+        std::chrono::milliseconds GetElapsed() const;
+        std::chrono::milliseconds GetSoftLimit() const;
+        std::chrono::milliseconds GetHardLimit() const;
+
+    private:
+        std::chrono::steady_clock::time_point mStart;
+        std::chrono::milliseconds             mSoft{0};
+        std::chrono::milliseconds             mHard{0};
+        bool                                  mTimed{false};
+        bool                                  mFixed{false};
+        bool                                  mForced{false};
+
+        Move mBest;
+        int  mStability{0};
+    };
+} // namespace xt
\ No newline at end of file
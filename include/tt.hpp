@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace xt {
+    // Shared between all search threads. Each slot stores its key XORed with its data, so a torn
+    // write from two threads racing on the same slot fails validation instead of being trusted.
+    class TranspositionTable {
+    public:
+        enum Bound : std::uint8_t { NONE, UPPER, LOWER, EXACT };
+
+        struct Entry {
+            std::uint16_t move{0};
+            std::int16_t  score{0};
+            std::int16_t  eval{0}; // static evaluation, unless in check
+            std::uint8_t  depth{0};
+            Bound         bound{Bound::NONE};
+        };
+
+    public:
+        explicit TranspositionTable(std::size_t megabytes = 16);
+
+        void Resize(std::size_t megabytes);
+        void Clear();
+        void NewSearch();
+
+        bool Probe(std::uint64_t key, Entry &entry) const;
+        void Store(std::uint64_t key, const Entry &entry);
+
+        // Permille of sampled slots written during the current search
+        int GetHashfull() const;
+
+    private:
+        struct Slot {
+            std::atomic<std::uint64_t> key;
+            std::atomic<std::uint64_t> data;
+        };
+
+        static std::uint64_t Pack(const Entry &entry, std::uint8_t generation);
+        static Entry         Unpack(std::uint64_t data);
+
+        Slot &GetSlot(std::uint64_t key) const;
+
+    private:
+        std::unique_ptr<Slot[]> mSlots;
+        std::size_t             mSize{0};
+        std::uint8_t            mGeneration{0};
+    };
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "binary.hpp"
+
+#include <vector>
+
+namespace xt {
+    bool CopyFile(std::FILE *source, std::FILE *dest) {
+        std::vector<std::uint8_t> buffer(1 << 20);
+        bool                      ok = true;
+        for (std::size_t read; (read = std::fread(buffer.data(), 1, buffer.size(), source));)
+            ok &= std::fwrite(buffer.data(), 1, read, dest) == read;
+        return ok;
+    }
+} // namespace xt
\ No newline at end of file
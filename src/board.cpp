@@ -1,8 +1,71 @@
 #include "board.hpp"
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <fmt/format.h>
 
+#include "nnue.hpp"
+#include "psqt.hpp"
+
+namespace xt {
+    namespace {
+        constexpr const Vector KNIGHT_OFFSETS[] = {
+            {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+        constexpr const Vector KING_OFFSETS[] = {
+            {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+        constexpr const Vector ROOK_DIRECTIONS[]   = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+        constexpr const Vector BISHOP_DIRECTIONS[] = {{1, 1}, {-1, 1}, {-1, -1}, {1, -1}};
+
+        constexpr const char PIECE_CHARS[] = "qkrnbp";
+
+        struct Zobrist {
+            std::uint64_t pieces[Team::MAX][Piece::MAX][Board::SIZE * Board::SIZE];
+            std::uint64_t castling[16];
+            std::uint64_t enPassant[Board::SIZE];
+            std::uint64_t turn;
+        };
+
+        constexpr std::uint64_t SplitMix64(std::uint64_t &state) {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z               = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z               = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        constexpr Zobrist GenerateZobrist() {
+            Zobrist       keys{};
+            std::uint64_t state = 0x1BADB002ull;
+            for (auto &team : keys.pieces)
+                for (auto &type : team)
+                    for (auto &key : type)
+                        key = SplitMix64(state);
+
+            for (auto &key : keys.castling)
+                key = SplitMix64(state);
+            for (auto &key : keys.enPassant)
+                key = SplitMix64(state);
+
+            keys.turn = SplitMix64(state);
+            return keys;
+        }
+
+        constexpr const Zobrist ZOBRIST = GenerateZobrist();
+
+        Team Opponent(Team team) {
+            return team == Team::WHITE ? Team::BLACK : Team::WHITE;
+        }
+
+        int Index(const Vector &pos) {
+            return pos.y * Board::SIZE + pos.x;
+        }
+
+        Vector FromIndex(int index) {
+            return {static_cast<Int>(index % Board::SIZE), static_cast<Int>(index / Board::SIZE)};
+        }
+    } // namespace
+} // namespace xt
+
 namespace xt {
     bool Piece::OpposingTeam(Team other) const {
         return team != other && other != Team::MAX && team != Team::MAX;
@@ -25,6 +88,44 @@ namespace xt {
     }
 } // namespace xt
 
+namespace xt {
+    bool Move::IsValid() const {
+        return src != INVALID_POS && dest != INVALID_POS;
+    }
+
+    std::uint16_t Move::Pack() const {
+        if (!IsValid())
+            return 0;
+
+        const int promote = promotion == Piece::MAX ? 0 : promotion + 1;
+        return static_cast<std::uint16_t>(Index(src) | (Index(dest) << 6) | (promote << 12));
+    }
+
+    Move Move::Unpack(std::uint16_t data) {
+        if (!data)
+            return {};
+
+        const int promote = (data >> 12) & 7;
+        return {FromIndex(data & 63),
+                FromIndex((data >> 6) & 63),
+                promote ? static_cast<Piece::Type>(promote - 1) : Piece::MAX};
+    }
+
+    std::string Move::ToString() const {
+        if (!IsValid())
+            return "0000";
+
+        auto result = fmt::format("{}{}{}{}",
+                                  static_cast<char>('a' + src.x),
+                                  Board::SIZE - src.y,
+                                  static_cast<char>('a' + dest.x),
+                                  Board::SIZE - dest.y);
+        if (promotion != Piece::MAX)
+            result += PIECE_CHARS[promotion];
+        return result;
+    }
+} // namespace xt
+
 namespace xt {
     Board::Board() {
         Initialize({
@@ -50,19 +151,13 @@ namespace xt {
 
         InitSide(2, 1, Team::WHITE);
         InitSide(SIZE - 1, SIZE, Team::BLACK);
+
+        Refresh();
     }
 
     // Utils
     Vector Board::GetKing(Team team) const {
-        const auto it = std::find_if(std::begin(mBoard), std::end(mBoard), [team](const auto &a) {
-            return a.type == Piece::KING && a.team == team;
-        });
-
-        if (it == std::end(mBoard))
-            return INVALID_POS;
-
-        const auto index = std::distance(std::begin(mBoard), it);
-        return {static_cast<Int>(index % SIZE), static_cast<Int>(index / SIZE)};
+        return mKings[team];
     }
 
     Team Board::GetTurn() const {
@@ -119,9 +214,43 @@ namespace xt {
         return IsValid(pos.x, pos.y);
     }
 
-    // Data
+    std::uint64_t Board::GetHash() const {
+        return mHash;
+    }
+
+    std::uint64_t Board::GetPawnHash() const {
+        return mPawnHash;
+    }
 
-    // TODO: real serialization/deserialization of the board, maybe support FEN?
+    int Board::GetHalfMoves() const {
+        return mHalfMoves;
+    }
+
+    int Board::GetFullMoves() const {
+        return mFullMoves;
+    }
+
+    int Board::GetPieceCount() const {
+        return mPieceCount;
+    }
+
+    Vector Board::GetEnPassant() const {
+        return mEnPassant;
+    }
+
+    Score Board::GetPieceSquares() const {
+        return mPieceSquares;
+    }
+
+    int Board::GetPhase() const {
+        return mPhase;
+    }
+
+    const Accumulator &Board::GetAccumulator() const {
+        return mAccumulator;
+    }
+
+    // Data
 
     std::vector<std::uint8_t> Board::Save() const {
         std::vector<std::uint8_t> data(sizeof(*this), '\0');
@@ -134,19 +263,193 @@ namespace xt {
             return false;
 
         std::memcpy(this, data.data(), data.size());
+
+        // The accumulator may have been saved with another network
+        Refresh();
         return true;
     }
 
+    bool Board::LoadFen(std::string_view fen) {
+        std::vector<std::string_view> fields;
+        while (!fen.empty()) {
+            const auto end = std::min(fen.find(' '), fen.size());
+            if (end)
+                fields.push_back(fen.substr(0, end));
+            fen.remove_prefix(std::min(end + 1, fen.size()));
+        }
+
+        if (fields.size() < 2)
+            return false;
+
+        Board board{*this};
+        for (auto &piece : board.mBoard)
+            piece = Piece{};
+
+        Int x = 0, y = 0;
+        for (const char c : fields[0]) {
+            if (c == '/') {
+                if (x != SIZE || ++y >= SIZE)
+                    return false;
+                x = 0;
+            } else if (c >= '1' && c <= '8') {
+                x += c - '0';
+            } else {
+                const auto type = std::strchr(PIECE_CHARS, std::tolower(c));
+                if (!type || !*type || x >= SIZE)
+                    return false;
+
+                auto &piece = board(x++, y);
+                piece.type  = static_cast<Piece::Type>(type - PIECE_CHARS);
+                piece.team  = std::isupper(c) ? Team::WHITE : Team::BLACK;
+                piece.moved = piece.type == Piece::KING || piece.type == Piece::ROOK;
+                if (piece.type == Piece::PAWN)
+                    piece.moved = y != (piece.team == Team::WHITE ? SIZE - 2 : 1);
+            }
+
+            if (x > SIZE)
+                return false;
+        }
+
+        if (x != SIZE || y != SIZE - 1)
+            return false;
+
+        if (fields[1] != "w" && fields[1] != "b")
+            return false;
+
+        board.mTurn      = fields[1] == "w" ? Team::WHITE : Team::BLACK;
+        board.mPromoting = INVALID_POS;
+
+        if (fields.size() > 2) {
+            for (const char c : fields[2]) {
+                const Int  row  = std::isupper(c) ? SIZE - 1 : 0;
+                const Team team = std::isupper(c) ? Team::WHITE : Team::BLACK;
+                const Int  rook = std::tolower(c) == 'k' ? SIZE - 1 : 0;
+                if (std::tolower(c) != 'k' && std::tolower(c) != 'q')
+                    continue;
+
+                auto &king = board(4, row);
+                auto &rp   = board(rook, row);
+                if (king.type == Piece::KING && king.team == team && rp.type == Piece::ROOK &&
+                    rp.team == team) {
+                    king.moved = false;
+                    rp.moved   = false;
+                }
+            }
+        }
+
+        board.mEnPassant = INVALID_POS;
+        if (fields.size() > 3 && fields[3].size() == 2) {
+            const Vector square(fields[3][0] - 'a', SIZE - (fields[3][1] - '0'));
+            const Vector pawn(square.x, square.y + (board.mTurn == Team::WHITE ? 1 : -1));
+            if (board.IsValid(square) && board.IsValid(pawn)) {
+                for (Int ex = pawn.x - 1; ex <= pawn.x + 1; ex += 2) {
+                    if (!board.IsValid(ex, pawn.y))
+                        continue;
+
+                    auto &enemy = board(ex, pawn.y);
+                    if (enemy.type == Piece::PAWN && enemy.team == board.mTurn &&
+                        board(pawn).type == Piece::PAWN && board(pawn).OpposingTeam(enemy.team)) {
+                        enemy.enPassant  = pawn;
+                        board.mEnPassant = pawn;
+                    }
+                }
+            }
+        }
+
+        board.mHalfMoves = fields.size() > 4 ? std::atoi(std::string(fields[4]).c_str()) : 0;
+        board.mFullMoves = fields.size() > 5 ? std::atoi(std::string(fields[5]).c_str()) : 1;
+        board.Refresh();
+
+        if (!board.IsValid(board.mKings[Team::WHITE]) || !board.IsValid(board.mKings[Team::BLACK]))
+            return false;
+
+        *this = board;
+        return true;
+    }
+
+    bool Board::Setup(const std::vector<std::pair<Vector, Piece>> &pieces, Team turn) {
+        for (auto &piece : mBoard)
+            piece = Piece{};
+
+        for (const auto &[pos, piece] : pieces) {
+            auto &square = (*this)(pos);
+            square.type  = piece.type;
+            square.team  = piece.team;
+            square.moved = piece.type != Piece::PAWN ||
+                           pos.y != (piece.team == Team::WHITE ? SIZE - 2 : 1);
+        }
+
+        mTurn      = turn;
+        mPromoting = INVALID_POS;
+        mEnPassant = INVALID_POS;
+        mHalfMoves = 0;
+        mFullMoves = 1;
+        Refresh();
+
+        return IsValid(mKings[Team::WHITE]) && IsValid(mKings[Team::BLACK]);
+    }
+
+    std::string Board::GetFen() const {
+        std::string fen;
+        for (Int y = 0; y < SIZE; y++) {
+            int empty = 0;
+            for (Int x = 0; x < SIZE; x++) {
+                const auto &piece = (*this)(x, y);
+                if (piece.IsEmpty()) {
+                    empty++;
+                    continue;
+                }
+
+                if (empty)
+                    fen += static_cast<char>('0' + empty);
+                empty = 0;
+
+                const char c = PIECE_CHARS[piece.type];
+                fen += piece.team == Team::WHITE ? static_cast<char>(std::toupper(c)) : c;
+            }
+
+            if (empty)
+                fen += static_cast<char>('0' + empty);
+            if (y != SIZE - 1)
+                fen += '/';
+        }
+
+        fen += mTurn == Team::WHITE ? " w " : " b ";
+
+        const auto rights = GetCastlingRights();
+        for (int i = 0; i < 4; i++)
+            if (rights & (1 << i))
+                fen += "KQkq"[i];
+        if (!rights)
+            fen += '-';
+
+        if (IsValid(mEnPassant)) {
+            const Int y = mEnPassant.y + (mTurn == Team::WHITE ? -1 : 1);
+            fen += fmt::format(" {}{}", static_cast<char>('a' + mEnPassant.x), SIZE - y);
+        } else {
+            fen += " -";
+        }
+
+        return fen + fmt::format(" {} {}", mHalfMoves, mFullMoves);
+    }
+
     // Logic
 
     void Board::NextTurn() {
         mTurn = mTurn == Team::WHITE ? Team::BLACK : Team::WHITE;
+        mHash ^= ZOBRIST.turn;
+
+        if (mTurn == Team::WHITE)
+            mFullMoves++;
     }
 
     void Board::Promote(Piece::Type type) {
         if (IsValid(mPromoting)) {
+            Lift(mPromoting);
             (*this)(mPromoting).type = type;
-            mPromoting               = INVALID_POS;
+            Place(mPromoting);
+
+            mPromoting = INVALID_POS;
 
             NextTurn();
         }
@@ -155,13 +458,26 @@ namespace xt {
     void Board::Move(const Vector &src, const Vector &dest) {
         auto &piece  = (*this)(src);
         auto &target = (*this)(dest);
+
+        mHash ^= ZOBRIST.castling[GetCastlingRights()];
+        if (IsValid(mEnPassant))
+            mHash ^= ZOBRIST.enPassant[mEnPassant.x];
+
+        mHalfMoves = piece.type == Piece::PAWN || !target.IsEmpty() ? 0 : mHalfMoves + 1;
+        if (target.type == Piece::KING)
+            mKings[target.team] = INVALID_POS;
+
         if (piece.type == Piece::PAWN && IsValid(piece.enPassant) && src.x - dest.x != 0 &&
-            target.IsEmpty())
+            target.IsEmpty()) {
+            Lift(piece.enPassant);
             (*this)(piece.enPassant).Clear();
+        }
 
         for (auto &piece : mBoard)
             piece.enPassant = INVALID_POS;
 
+        mEnPassant = INVALID_POS;
+
         switch (piece.type) {
         case Piece::PAWN:
             if (abs(src.y - dest.y) == 2) {
@@ -170,8 +486,10 @@ namespace xt {
                         continue;
 
                     auto &enemy = (*this)(x, dest.y);
-                    if (enemy.type == Piece::PAWN && piece.OpposingTeam(enemy.team))
+                    if (enemy.type == Piece::PAWN && piece.OpposingTeam(enemy.team)) {
                         enemy.enPassant = dest;
+                        mEnPassant      = dest;
+                    }
                 }
             }
 
@@ -181,15 +499,381 @@ namespace xt {
 
             break;
         case Piece::KING:
-            if (auto rook = IsCastlingMove(src, dest))
-                (*this)(*rook).Move((*this)((dest.x - src.x) > 0 ? dest.x - 1 : dest.x + 1, src.y));
+            if (auto rook = IsCastlingMove(src, dest)) {
+                const Vector to((dest.x - src.x) > 0 ? dest.x - 1 : dest.x + 1, src.y);
+
+                Lift(*rook);
+                (*this)(*rook).Move((*this)(to));
+                Place(to);
+            }
 
+            mKings[piece.team] = dest;
             break;
         default:
             break;
         }
 
+        Lift(src);
+        Lift(dest);
         piece.Move(target);
+        Place(dest);
+
+        // Every feature of the mover's side depends on its king square
+        if (target.type == Piece::KING)
+            RefreshAccumulator(target.team);
+
+        mHash ^= ZOBRIST.castling[GetCastlingRights()];
+        if (IsValid(mEnPassant))
+            mHash ^= ZOBRIST.enPassant[mEnPassant.x];
+    }
+
+    void Board::MakeMove(const xt::Move &move) {
+        Move(move.src, move.dest);
+
+        if (IsValid(mPromoting))
+            Promote(move.promotion == Piece::MAX ? Piece::QUEEN : move.promotion);
+        else
+            NextTurn();
+    }
+
+    void Board::MakeNullMove() {
+        if (IsValid(mEnPassant)) {
+            mHash ^= ZOBRIST.enPassant[mEnPassant.x];
+            mEnPassant = INVALID_POS;
+
+            for (auto &piece : mBoard)
+                piece.enPassant = INVALID_POS;
+        }
+
+        mHalfMoves++;
+        NextTurn();
+    }
+
+    std::optional<xt::Move> Board::ParseMove(std::string_view text) const {
+        MoveList moves;
+        GenerateMoves(moves);
+
+        for (const auto &move : moves)
+            if (move.ToString() == text)
+                return move;
+
+        return std::nullopt;
+    }
+
+    std::optional<xt::Move> Board::ParseSan(std::string_view text) const {
+        while (!text.empty() && std::strchr("+#!?", text.back()))
+            text.remove_suffix(1);
+
+        // Pieces are named in upper case, except for pawns
+        const auto GetType = [](char c) {
+            if (!std::isupper(c) || c == 'P')
+                return Piece::MAX;
+
+            const auto type = std::strchr(PIECE_CHARS, std::tolower(c));
+            return type ? static_cast<Piece::Type>(type - PIECE_CHARS) : Piece::MAX;
+        };
+
+        auto   type = Piece::PAWN, promotion = Piece::MAX;
+        Vector dest;
+        int    file = -1, rank = -1;
+        if (text == "O-O" || text == "O-O-O" || text == "0-0" || text == "0-0-0") {
+            const auto king = mKings[mTurn];
+            if (!IsValid(king))
+                return std::nullopt;
+
+            type = Piece::KING;
+            dest = {static_cast<Int>(king.x + (text.size() == 3 ? 2 : -2)), king.y};
+        } else {
+            if (text.size() > 2 && GetType(text.back()) != Piece::MAX) {
+                promotion = GetType(text.back());
+                text.remove_suffix(text[text.size() - 2] == '=' ? 2 : 1);
+            }
+
+            if (!text.empty() && GetType(text[0]) != Piece::MAX) {
+                type = GetType(text[0]);
+                text.remove_prefix(1);
+            }
+
+            if (text.size() < 2)
+                return std::nullopt;
+
+            const char col = text[text.size() - 2], row = text.back();
+            if (col < 'a' || col > 'h' || row < '1' || row > '8')
+                return std::nullopt;
+
+            dest = {static_cast<Int>(col - 'a'), static_cast<Int>('8' - row)};
+            text.remove_suffix(2);
+
+            // Whatever is left disambiguates the source square, 'x' marks a capture
+            for (const char c : text) {
+                if (c >= 'a' && c <= 'h')
+                    file = c - 'a';
+                else if (c >= '1' && c <= '8')
+                    rank = '8' - c;
+            }
+        }
+
+        Vector    origins[MAX_ORIGINS];
+        const int count = FindOrigins(type, dest, file, rank, origins);
+
+        // The notation must pick out exactly one legal move
+        std::optional<xt::Move> result;
+        MoveList                moves;
+        for (int i = 0; i < count; i++) {
+            moves.Clear();
+            GeneratePieceMoves(origins[i], moves);
+            for (const auto &move : moves) {
+                if (move.dest != dest || move.promotion != promotion || !IsLegal(move))
+                    continue;
+                if (result)
+                    return std::nullopt;
+
+                result = move;
+            }
+        }
+
+        return result;
+    }
+
+    std::string Board::GetSan(const xt::Move &move) const {
+        const auto &piece = (*this)(move.src);
+
+        std::string result;
+        if (piece.type == Piece::KING && std::abs(move.dest.x - move.src.x) == 2) {
+            result = move.dest.x > move.src.x ? "O-O" : "O-O-O";
+        } else {
+            const bool capture = IsCapture(move);
+            if (piece.type == Piece::PAWN) {
+                if (capture)
+                    result += static_cast<char>('a' + move.src.x);
+            } else {
+                result += static_cast<char>(std::toupper(PIECE_CHARS[piece.type]));
+
+                // Name the file, the rank or both if another piece of the type can get there
+                Vector    origins[MAX_ORIGINS];
+                const int count     = FindOrigins(piece.type, move.dest, -1, -1, origins);
+                bool      ambiguous = false, file = false, rank = false;
+                for (int i = 0; i < count; i++) {
+                    if (origins[i] == move.src || !IsLegal({origins[i], move.dest}))
+                        continue;
+
+                    ambiguous = true;
+                    file      = file || origins[i].x == move.src.x;
+                    rank      = rank || origins[i].y == move.src.y;
+                }
+
+                if (ambiguous && (!file || rank))
+                    result += static_cast<char>('a' + move.src.x);
+                if (ambiguous && file)
+                    result += static_cast<char>('0' + SIZE - move.src.y);
+            }
+
+            if (capture)
+                result += 'x';
+
+            result += static_cast<char>('a' + move.dest.x);
+            result += static_cast<char>('0' + SIZE - move.dest.y);
+            if (move.promotion != Piece::MAX) {
+                result += '=';
+                result += static_cast<char>(std::toupper(PIECE_CHARS[move.promotion]));
+            }
+        }
+
+        Board copy{*this};
+        copy.MakeMove(move);
+        if (copy.InCheck())
+            result += copy.HasLegalMove() ? '+' : '#';
+        return result;
+    }
+
+    int Board::FindOrigins(Piece::Type  type,
+                           const Vector &dest,
+                           int           file,
+                           int           rank,
+                           Vector (&origins)[MAX_ORIGINS]) const {
+        int        count    = 0;
+        const auto Consider = [&](int x, int y) {
+            if (!IsValid(x, y) || (file >= 0 && x != file) || (rank >= 0 && y != rank))
+                return;
+
+            const auto &piece = mBoard[y * SIZE + x];
+            if (piece.team == mTurn && piece.type == type)
+                origins[count++] = {static_cast<Int>(x), static_cast<Int>(y)};
+        };
+
+        const auto Slide = [&](const Vector(&directions)[4]) {
+            for (const auto &dir : directions) {
+                int x = dest.x + dir.x, y = dest.y + dir.y;
+                for (; IsValid(x, y) && mBoard[y * SIZE + x].IsEmpty(); x += dir.x, y += dir.y) { }
+                Consider(x, y);
+            }
+        };
+
+        switch (type) {
+        case Piece::PAWN:
+        {
+            const int back = mTurn == Team::WHITE ? 1 : -1;
+            if (file >= 0 && file != dest.x) {
+                Consider(file, dest.y + back);
+            } else {
+                Consider(dest.x, dest.y + back);
+                if (IsValid(dest.x, dest.y + back) && (*this)(dest.x, dest.y + back).IsEmpty())
+                    Consider(dest.x, dest.y + back * 2);
+            }
+        } break;
+        case Piece::KNIGHT:
+            for (const auto &offset : KNIGHT_OFFSETS)
+                Consider(dest.x + offset.x, dest.y + offset.y);
+            break;
+        case Piece::KING:
+            Consider(mKings[mTurn].x, mKings[mTurn].y);
+            break;
+        case Piece::ROOK:
+            Slide(ROOK_DIRECTIONS);
+            break;
+        case Piece::BISHOP:
+            Slide(BISHOP_DIRECTIONS);
+            break;
+        default:
+            Slide(ROOK_DIRECTIONS);
+            Slide(BISHOP_DIRECTIONS);
+            break;
+        }
+
+        return count;
+    }
+
+    bool Board::IsLegal(const xt::Move &move) const {
+        Board copy{*this};
+        copy.Move(move.src, move.dest);
+        return !copy.IsKingInCheck(mTurn);
+    }
+
+    bool Board::HasLegalMove() const {
+        MoveList moves;
+        for (int i = 0; i < SIZE * SIZE; i++) {
+            if (mBoard[i].team != mTurn)
+                continue;
+
+            moves.Clear();
+            GeneratePieceMoves(FromIndex(i), moves);
+            for (const auto &move : moves)
+                if (IsLegal(move))
+                    return true;
+        }
+
+        return false;
+    }
+
+    void Board::Place(const Vector &pos) {
+        const auto &piece = (*this)(pos);
+        if (piece.IsEmpty())
+            return;
+
+        mHash ^= ZOBRIST.pieces[piece.team][piece.type][Index(pos)];
+        if (piece.type == Piece::PAWN)
+            mPawnHash ^= ZOBRIST.pieces[piece.team][piece.type][Index(pos)];
+
+        mPhase += PHASE_WEIGHTS[piece.type];
+        mPieceCount++;
+        if (piece.team == Team::WHITE)
+            mPieceSquares += GetPieceSquare(piece.team, piece.type, Index(pos));
+        else
+            mPieceSquares -= GetPieceSquare(piece.team, piece.type, Index(pos));
+
+        const auto *network = Network::GetActive();
+        if (piece.type == Piece::KING || !network || mAccumulator.network != network->GetId())
+            return;
+
+        for (const auto team : {Team::WHITE, Team::BLACK})
+            if (IsValid(mKings[team]))
+                network->AddFeature(
+                    mAccumulator, team, Network::GetFeature(team, mKings[team], piece, pos));
+    }
+
+    void Board::Lift(const Vector &pos) {
+        const auto &piece = (*this)(pos);
+        if (piece.IsEmpty())
+            return;
+
+        mHash ^= ZOBRIST.pieces[piece.team][piece.type][Index(pos)];
+        if (piece.type == Piece::PAWN)
+            mPawnHash ^= ZOBRIST.pieces[piece.team][piece.type][Index(pos)];
+
+        mPhase -= PHASE_WEIGHTS[piece.type];
+        mPieceCount--;
+        if (piece.team == Team::WHITE)
+            mPieceSquares -= GetPieceSquare(piece.team, piece.type, Index(pos));
+        else
+            mPieceSquares += GetPieceSquare(piece.team, piece.type, Index(pos));
+
+        const auto *network = Network::GetActive();
+        if (piece.type == Piece::KING || !network || mAccumulator.network != network->GetId())
+            return;
+
+        for (const auto team : {Team::WHITE, Team::BLACK})
+            if (IsValid(mKings[team]))
+                network->RemoveFeature(
+                    mAccumulator, team, Network::GetFeature(team, mKings[team], piece, pos));
+    }
+
+    std::uint8_t Board::GetCastlingRights() const {
+        std::uint8_t rights = 0;
+        for (const auto team : {Team::WHITE, Team::BLACK}) {
+            const Int   row  = team == Team::WHITE ? SIZE - 1 : 0;
+            const auto &king = mBoard[row * SIZE + 4];
+            if (king.type != Piece::KING || king.team != team || king.moved)
+                continue;
+
+            const auto CanCastle = [&](Int x) {
+                const auto &rook = mBoard[row * SIZE + x];
+                return rook.type == Piece::ROOK && rook.team == team && !rook.moved;
+            };
+
+            const int shift = team == Team::WHITE ? 0 : 2;
+            if (CanCastle(SIZE - 1))
+                rights |= 1 << shift;
+            if (CanCastle(0))
+                rights |= 2 << shift;
+        }
+
+        return rights;
+    }
+
+    void Board::Refresh() {
+        mHash                = 0;
+        mPawnHash            = 0;
+        mPieceSquares        = {};
+        mPhase               = 0;
+        mPieceCount          = 0;
+        mAccumulator.network = 0;
+        mKings[Team::WHITE]  = mKings[Team::BLACK] = INVALID_POS;
+
+        for (int i = 0; i < SIZE * SIZE; i++) {
+            const auto pos = FromIndex(i);
+            if (mBoard[i].type == Piece::KING && mBoard[i].team != Team::MAX)
+                mKings[mBoard[i].team] = pos;
+
+            Place(pos);
+        }
+
+        mHash ^= ZOBRIST.castling[GetCastlingRights()];
+        if (IsValid(mEnPassant))
+            mHash ^= ZOBRIST.enPassant[mEnPassant.x];
+        if (mTurn == Team::BLACK)
+            mHash ^= ZOBRIST.turn;
+
+        if (const auto *network = Network::GetActive()) {
+            mAccumulator.network = network->GetId();
+            RefreshAccumulator(Team::WHITE);
+            RefreshAccumulator(Team::BLACK);
+        }
+    }
+
+    void Board::RefreshAccumulator(Team perspective) {
+        const auto *network = Network::GetActive();
+        if (network && mAccumulator.network == network->GetId())
+            network->Refresh(*this, perspective, mAccumulator);
     }
 
     bool Board::TryMove(const Vector &src, const Vector &dest) {
@@ -322,12 +1006,65 @@ namespace xt {
     }
 
     bool Board::IsInCheck(Team team, const Vector &king) const {
-        for (Int y = 0; y < SIZE; y++)
-            for (Int x = 0; x < SIZE; x++)
-                if ((*this)(x, y).OpposingTeam(team) && IsValidMove({x, y}, king))
-                    return true;
+        return IsAttacked(king, Opponent(team));
+    }
 
-        return false;
+    bool Board::InCheck() const {
+        return IsKingInCheck(mTurn);
+    }
+
+    bool Board::IsCapture(const xt::Move &move) const {
+        const auto &piece = (*this)(move.src);
+        return !(*this)(move.dest).IsEmpty() ||
+               (piece.type == Piece::PAWN && move.src.x != move.dest.x);
+    }
+
+    bool Board::HasNonPawnMaterial(Team team) const {
+        return std::any_of(std::begin(mBoard), std::end(mBoard), [team](const auto &piece) {
+            return piece.team == team && piece.type != Piece::PAWN && piece.type != Piece::KING;
+        });
+    }
+
+    bool Board::IsAttacked(const Vector &pos, Team by) const {
+        const auto Holds = [&](int x, int y, Piece::Type type) {
+            if (!IsValid(x, y))
+                return false;
+
+            const auto &piece = mBoard[y * SIZE + x];
+            return piece.team == by && piece.type == type;
+        };
+
+        // Pawns capture towards the opposing side, so attackers sit one row behind pos
+        const int pawnRow = pos.y + (by == Team::WHITE ? 1 : -1);
+        if (Holds(pos.x - 1, pawnRow, Piece::PAWN) || Holds(pos.x + 1, pawnRow, Piece::PAWN))
+            return true;
+
+        for (const auto &offset : KNIGHT_OFFSETS)
+            if (Holds(pos.x + offset.x, pos.y + offset.y, Piece::KNIGHT))
+                return true;
+
+        for (const auto &offset : KING_OFFSETS)
+            if (Holds(pos.x + offset.x, pos.y + offset.y, Piece::KING))
+                return true;
+
+        const auto Slides = [&](const Vector(&directions)[4], Piece::Type type) {
+            for (const auto &dir : directions) {
+                int x = pos.x + dir.x, y = pos.y + dir.y;
+                for (; IsValid(x, y); x += dir.x, y += dir.y) {
+                    const auto &piece = mBoard[y * SIZE + x];
+                    if (piece.IsEmpty())
+                        continue;
+
+                    if (piece.team == by && (piece.type == type || piece.type == Piece::QUEEN))
+                        return true;
+                    break;
+                }
+            }
+
+            return false;
+        };
+
+        return Slides(ROOK_DIRECTIONS, Piece::ROOK) || Slides(BISHOP_DIRECTIONS, Piece::BISHOP);
     }
 
     bool Board::IsKingInCheck(Team team) const {
@@ -379,6 +1116,116 @@ namespace xt {
         return moves;
     }
 
+    void Board::GenerateMoves(MoveList &moves) const {
+        MoveList pseudo;
+        for (int i = 0; i < SIZE * SIZE; i++)
+            if (mBoard[i].team == mTurn)
+                GeneratePieceMoves(FromIndex(i), pseudo);
+
+        for (const auto &move : pseudo) {
+            Board copy{*this};
+            copy.Move(move.src, move.dest);
+            if (!copy.IsKingInCheck(mTurn))
+                moves.Add(move);
+        }
+    }
+
+    void Board::GeneratePieceMoves(const Vector &src, MoveList &moves) const {
+        const auto &piece = (*this)(src);
+        const auto  Add   = [&](int x, int y) {
+            moves.Add({src, {static_cast<Int>(x), static_cast<Int>(y)}});
+        };
+
+        // Returns true if the square could be moved to, or false if it holds a friendly piece
+        const auto Target = [&](int x, int y) {
+            if (!IsValid(x, y) || mBoard[y * SIZE + x].team == piece.team)
+                return false;
+
+            Add(x, y);
+            return true;
+        };
+
+        const auto Slide = [&](const Vector(&directions)[4]) {
+            for (const auto &dir : directions) {
+                int x = src.x + dir.x, y = src.y + dir.y;
+                for (; Target(x, y) && mBoard[y * SIZE + x].IsEmpty(); x += dir.x, y += dir.y) { }
+            }
+        };
+
+        switch (piece.type) {
+        case Piece::PAWN:
+        {
+            const int  forward = piece.team == Team::WHITE ? -1 : 1;
+            const int  last    = piece.team == Team::WHITE ? 0 : SIZE - 1;
+            const auto AddPawn = [&](int x, int y) {
+                if (y != last)
+                    return Add(x, y);
+
+                for (const auto type : {Piece::QUEEN, Piece::KNIGHT, Piece::ROOK, Piece::BISHOP})
+                    moves.Add({src, {static_cast<Int>(x), static_cast<Int>(y)}, type});
+            };
+
+            const int y = src.y + forward;
+            if (!IsValid(src.x, y))
+                break;
+
+            if (mBoard[y * SIZE + src.x].IsEmpty()) {
+                AddPawn(src.x, y);
+                if (!piece.moved && IsValid(src.x, y + forward) &&
+                    mBoard[(y + forward) * SIZE + src.x].IsEmpty())
+                    Add(src.x, y + forward);
+            }
+
+            for (int x = src.x - 1; x <= src.x + 1; x += 2) {
+                if (!IsValid(x, y))
+                    continue;
+
+                if (mBoard[y * SIZE + x].OpposingTeam(piece.team))
+                    AddPawn(x, y);
+                else if (mBoard[y * SIZE + x].IsEmpty() && piece.enPassant == Vector(x, src.y))
+                    Add(x, y);
+            }
+        } break;
+        case Piece::KNIGHT:
+            for (const auto &offset : KNIGHT_OFFSETS)
+                Target(src.x + offset.x, src.y + offset.y);
+            break;
+        case Piece::KING:
+            for (const auto &offset : KING_OFFSETS)
+                Target(src.x + offset.x, src.y + offset.y);
+
+            if (piece.moved || IsAttacked(src, Opponent(piece.team)))
+                break;
+
+            for (const int dir : {1, -1}) {
+                const auto &rook = (*this)(dir > 0 ? SIZE - 1 : 0, src.y);
+                if (rook.type != Piece::ROOK || rook.team != piece.team || rook.moved)
+                    continue;
+
+                bool clear = true;
+                for (int x = src.x + dir; x > 0 && x < SIZE - 1; x += dir)
+                    clear = clear && mBoard[src.y * SIZE + x].IsEmpty();
+
+                if (clear && !IsAttacked({static_cast<Int>(src.x + dir), src.y},
+                                         Opponent(piece.team)))
+                    Add(src.x + dir * 2, src.y);
+            }
+            break;
+        case Piece::ROOK:
+            Slide(ROOK_DIRECTIONS);
+            break;
+        case Piece::BISHOP:
+            Slide(BISHOP_DIRECTIONS);
+            break;
+        case Piece::QUEEN:
+            Slide(ROOK_DIRECTIONS);
+            Slide(BISHOP_DIRECTIONS);
+            break;
+        default:
+            break;
+        }
+    }
+
     std::optional<Vector> Board::IsCastlingMove(const Vector &src, const Vector &dest) const {
         const auto &king = (*this)(src);
         if (abs(dest.x - src.x) != 2 || (dest.y - src.y) != 0 || king.moved ||
@@ -0,0 +1,97 @@
+#include "eval.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "kpk.hpp"
+#include "nnue.hpp"
+#include "psqt.hpp"
+
+namespace xt {
+    namespace {
+        // Endings known exactly without search, with score from the side to move's view
+        bool EvaluateEndgame(const Board &board, int &score) {
+            if (board.GetPhase())
+                return false;
+
+            Vector pawn = INVALID_POS;
+            for (Int y = 0; y < Board::SIZE; y++) {
+                for (Int x = 0; x < Board::SIZE; x++) {
+                    if (board[{x, y}].type != Piece::PAWN)
+                        continue;
+                    if (board.IsValid(pawn))
+                        return false;
+
+                    pawn = {x, y};
+                }
+            }
+
+            if (!board.IsValid(pawn) || pawn.y == 0 || pawn.y == Board::SIZE - 1 ||
+                !board.IsValid(board.GetKing(Team::WHITE)) ||
+                !board.IsValid(board.GetKing(Team::BLACK)))
+                return false;
+
+            if (!Kpk::Probe(board, pawn)) {
+                score = 0;
+                return true;
+            }
+
+            // Still reward progress so the search pushes the pawn home
+            const Team strong = board[pawn].team;
+            const int  rank   = strong == Team::WHITE ? Board::SIZE - 1 - pawn.y : pawn.y;
+            score             = SCORE_KNOWN_WIN + PIECE_VALUES[Piece::PAWN] + 10 * rank;
+            if (board.GetTurn() != strong)
+                score = -score;
+
+            return true;
+        }
+
+        int Evaluate(const Board &board, const PawnTable::Entry &pawns) {
+            // Debug builds check the sums Board keeps up to date against a full recomputation
+            assert(board.GetPieceSquares() == ComputePieceSquares(board));
+            assert(board.GetPhase() == ComputePhase(board));
+
+            auto total = board.GetPieceSquares();
+            total += pawns.score;
+
+            // Pawn shields only matter to a king that is still at home
+            for (const auto team : {Team::WHITE, Team::BLACK}) {
+                const auto king = board.GetKing(team);
+                const Int  rank = team == Team::WHITE ? Board::SIZE - 1 - king.y : king.y;
+                if (!board.IsValid(king) || rank > 1)
+                    continue;
+
+                const int shelter = pawns.shelter[team][king.x];
+                total.mg += team == Team::WHITE ? shelter : -shelter;
+            }
+
+            const int phase = std::min(board.GetPhase(), PHASE_MAX);
+            const int score = (total.mg * phase + total.eg * (PHASE_MAX - phase)) / PHASE_MAX;
+            return board.GetTurn() == Team::WHITE ? score : -score;
+        }
+    } // namespace
+
+    int Evaluate(const Board &board) {
+        int score;
+        if (EvaluateEndgame(board, score))
+            return score;
+
+        if (const auto *network = Network::GetActive())
+            return network->Evaluate(board);
+
+        PawnTable::Entry pawns;
+        PawnTable::Compute(board, pawns);
+        return Evaluate(board, pawns);
+    }
+
+    int Evaluate(const Board &board, PawnTable &pawns) {
+        int score;
+        if (EvaluateEndgame(board, score))
+            return score;
+
+        if (const auto *network = Network::GetActive())
+            return network->Evaluate(board);
+
+        return Evaluate(board, pawns.Probe(board));
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "evalcache.hpp"
+
+namespace xt {
+    namespace {
+        constexpr const std::uint64_t SCORE_MASK = 0xFFFF;
+    } // namespace
+
+    EvalCache::EvalCache(std::size_t kilobytes) {
+        Resize(kilobytes);
+    }
+
+    void EvalCache::Resize(std::size_t kilobytes) {
+        // Round down to a power of two so the index is a mask of the key
+        std::size_t size = kilobytes * 1024 / sizeof(std::uint64_t);
+        while (size & (size - 1))
+            size &= size - 1;
+
+        mSlots = size ? std::make_unique<std::uint64_t[]>(size) : nullptr;
+        mMask  = size ? size - 1 : 0;
+        Clear();
+    }
+
+    void EvalCache::Clear() {
+        // A zeroed slot only matches a key whose upper bits are all zero, which is as unlikely as
+        // any other collision
+        if (mSlots)
+            for (std::size_t i = 0; i <= mMask; i++)
+                mSlots[i] = 0;
+    }
+
+    bool EvalCache::Probe(std::uint64_t key, int &score) {
+        if (!mSlots)
+            return false;
+
+        mProbes++;
+        const auto slot = mSlots[key & mMask];
+        if ((slot ^ key) & ~SCORE_MASK)
+            return false;
+
+        mHits++;
+        score = static_cast<std::int16_t>(slot & SCORE_MASK);
+        return true;
+    }
+
+    void EvalCache::Store(std::uint64_t key, int score) {
+        if (mSlots)
+            mSlots[key & mMask] = (key & ~SCORE_MASK) | static_cast<std::uint16_t>(score);
+    }
+
+    void EvalCache::ResetStats() {
+        mProbes = mHits = 0;
+    }
+
+    std::uint64_t EvalCache::GetProbes() const {
+        return mProbes;
+    }
+
+    std::uint64_t EvalCache::GetHits() const {
+        return mHits;
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "gamedb.hpp"
+
+#include "binary.hpp"
+
+namespace xt {
+    namespace {
+        constexpr const char *TAG_NAMES[] = {
+            "Event", "Site", "Date", "Round", "White", "Black", "FEN"};
+
+        constexpr const char *RESULTS[] = {"*", "1-0", "0-1", "1/2-1/2"};
+
+        // Where each field sits in a header or an index entry
+        constexpr const std::size_t HEADER_GAMES   = 8;
+        constexpr const std::size_t HEADER_STRINGS = 16;
+        constexpr const std::size_t HEADER_INDEX   = 24;
+        constexpr const std::size_t HEADER_TEXT    = 32;
+
+        constexpr const std::size_t ENTRY_MOVES  = 0;
+        constexpr const std::size_t ENTRY_PLIES  = 8;
+        constexpr const std::size_t ENTRY_RESULT = 12;
+        constexpr const std::size_t ENTRY_TAGS   = 16;
+    } // namespace
+
+    const char *GameDatabase::GetTagName(Tag tag) {
+        return TAG_NAMES[tag];
+    }
+
+    GameDatabase::Result GameDatabase::ParseResult(std::string_view text) {
+        for (int i = 0; i < static_cast<int>(std::size(RESULTS)); i++)
+            if (text == RESULTS[i])
+                return static_cast<Result>(i);
+        return UNFINISHED;
+    }
+
+    std::string_view GameDatabase::GetResultText(Result result) {
+        return RESULTS[result];
+    }
+
+    bool GameDatabase::Open(const std::string &path) {
+        Close();
+        if (!mFile.Open(path) || mFile.GetSize() < HEADER_SIZE)
+            return Close(), false;
+
+        const auto *data = mFile.GetData();
+        const auto  size = mFile.GetSize();
+        if (ReadLittleEndian<std::uint32_t>(data) != MAGIC ||
+            ReadLittleEndian<std::uint32_t>(data + 4) != VERSION)
+            return Close(), false;
+
+        const auto games   = ReadLittleEndian<std::uint64_t>(data + HEADER_GAMES);
+        const auto strings = ReadLittleEndian<std::uint64_t>(data + HEADER_STRINGS);
+        const auto index   = ReadLittleEndian<std::uint64_t>(data + HEADER_INDEX);
+        const auto text    = ReadLittleEndian<std::uint64_t>(data + HEADER_TEXT);
+        if (index > size || games > (size - index) / ENTRY_SIZE || text > size ||
+            strings >= (size - text) / sizeof(std::uint64_t))
+            return Close(), false;
+
+        mGames   = games;
+        mStrings = strings;
+        mIndex   = data + index;
+        mOffsets = data + text;
+        return true;
+    }
+
+    void GameDatabase::Close() {
+        mFile.Close();
+        mGames   = 0;
+        mStrings = 0;
+        mIndex   = nullptr;
+        mOffsets = nullptr;
+    }
+
+    std::size_t GameDatabase::GetSize() const {
+        return mGames;
+    }
+
+    std::string_view GameDatabase::GetTag(std::size_t game, Tag tag) const {
+        const auto id = ReadLittleEndian<std::uint32_t>(GetEntry(game) + ENTRY_TAGS + tag * 4);
+        if (id >= mStrings)
+            return {};
+
+        // The text of every string follows the table of their offsets
+        const auto *text  = reinterpret_cast<const char *>(mOffsets) + (mStrings + 1) * 8;
+        const auto  size  = mFile.GetData() + mFile.GetSize() - mOffsets - (mStrings + 1) * 8;
+        const auto  begin = ReadLittleEndian<std::uint64_t>(mOffsets + id * 8);
+        const auto  end   = ReadLittleEndian<std::uint64_t>(mOffsets + id * 8 + 8);
+        if (begin > end || end > static_cast<std::uint64_t>(size))
+            return {};
+
+        return {text + begin, end - begin};
+    }
+
+    GameDatabase::Result GameDatabase::GetResult(std::size_t game) const {
+        const auto result = GetEntry(game)[ENTRY_RESULT];
+        return result <= DRAWN ? static_cast<Result>(result) : UNFINISHED;
+    }
+
+    std::size_t GameDatabase::GetPlies(std::size_t game) const {
+        // Moves that would run past the end of the file are treated as missing
+        const auto *entry  = GetEntry(game);
+        const auto  offset = ReadLittleEndian<std::uint64_t>(entry + ENTRY_MOVES);
+        const auto  plies  = ReadLittleEndian<std::uint32_t>(entry + ENTRY_PLIES);
+        if (offset > mFile.GetSize() || plies > (mFile.GetSize() - offset) / 2)
+            return 0;
+
+        return plies;
+    }
+
+    Move GameDatabase::GetMove(std::size_t game, std::size_t ply) const {
+        if (ply >= GetPlies(game))
+            return {};
+
+        const auto offset = ReadLittleEndian<std::uint64_t>(GetEntry(game) + ENTRY_MOVES);
+        return Move::Unpack(ReadLittleEndian<std::uint16_t>(mFile.GetData() + offset + ply * 2));
+    }
+
+    bool GameDatabase::Setup(std::size_t game, Board &board) const {
+        static const Board START;
+
+        const auto fen = GetTag(game, FEN);
+        if (fen.empty()) {
+            board = START;
+            return true;
+        }
+
+        return board.LoadFen(fen);
+    }
+
+    const std::uint8_t *GameDatabase::GetEntry(std::size_t game) const {
+        return mIndex + game * ENTRY_SIZE;
+    }
+
+    GameDatabaseWriter::~GameDatabaseWriter() {
+        if (mFile)
+            std::fclose(mFile);
+        if (mIndex) {
+            std::fclose(mIndex);
+            std::remove((mPath + ".index").c_str());
+        }
+    }
+
+    bool GameDatabaseWriter::Open(const std::string &path) {
+        mPath  = path;
+        mFile  = std::fopen(path.c_str(), "wb");
+        mIndex = std::fopen((path + ".index").c_str(), "w+b");
+        if (!mFile || !mIndex)
+            return false;
+
+        // The header is filled in once everything else has been written
+        const std::uint8_t header[GameDatabase::HEADER_SIZE]{};
+        mFailed = std::fwrite(header, 1, sizeof(header), mFile) != sizeof(header);
+        mOffset = sizeof(header);
+        mGames  = 0;
+
+        mStringIds.clear();
+        mStrings.clear();
+        GetString({});
+        return !mFailed;
+    }
+
+    std::size_t GameDatabaseWriter::GetSize() const {
+        return mGames;
+    }
+
+    std::size_t GameDatabaseWriter::Add(const GameDatabase::Tags &tags,
+                                        GameDatabase::Result      result,
+                                        const std::uint16_t      *moves,
+                                        std::size_t               plies) {
+        std::uint8_t entry[GameDatabase::ENTRY_SIZE]{};
+        WriteLittleEndian<std::uint64_t>(entry + ENTRY_MOVES, mOffset);
+        WriteLittleEndian<std::uint32_t>(entry + ENTRY_PLIES, static_cast<std::uint32_t>(plies));
+        entry[ENTRY_RESULT] = result;
+        for (int tag = 0; tag < GameDatabase::TAGS; tag++)
+            WriteLittleEndian<std::uint32_t>(entry + ENTRY_TAGS + tag * 4, GetString(tags[tag]));
+
+        mMoves.resize(plies * sizeof(std::uint16_t));
+        for (std::size_t ply = 0; ply < plies; ply++)
+            WriteLittleEndian<std::uint16_t>(&mMoves[ply * sizeof(std::uint16_t)], moves[ply]);
+
+        if (std::fwrite(mMoves.data(), 1, mMoves.size(), mFile) != mMoves.size() ||
+            std::fwrite(entry, 1, sizeof(entry), mIndex) != sizeof(entry))
+            mFailed = true;
+
+        mOffset += mMoves.size();
+        return mGames++;
+    }
+
+    bool GameDatabaseWriter::Close() {
+        if (!mFile || !mIndex)
+            return false;
+
+        // Copy the index over from the scratch file
+        const std::uint64_t index = mOffset;
+        std::rewind(mIndex);
+        mFailed |= !CopyFile(mIndex, mFile);
+
+        const std::uint64_t text   = index + mGames * GameDatabase::ENTRY_SIZE;
+        std::uint64_t       offset = 0;
+        std::uint8_t        field[8];
+        for (std::size_t i = 0; i <= mStrings.size(); i++) {
+            WriteLittleEndian<std::uint64_t>(field, offset);
+            mFailed |= std::fwrite(field, 1, sizeof(field), mFile) != sizeof(field);
+            if (i < mStrings.size())
+                offset += mStrings[i].size();
+        }
+
+        for (const auto &string : mStrings)
+            mFailed |= std::fwrite(string.data(), 1, string.size(), mFile) != string.size();
+
+        std::uint8_t header[GameDatabase::HEADER_SIZE]{};
+        WriteLittleEndian<std::uint32_t>(header, GameDatabase::MAGIC);
+        WriteLittleEndian<std::uint32_t>(header + 4, GameDatabase::VERSION);
+        WriteLittleEndian<std::uint64_t>(header + HEADER_GAMES, mGames);
+        WriteLittleEndian<std::uint64_t>(header + HEADER_STRINGS, mStrings.size());
+        WriteLittleEndian<std::uint64_t>(header + HEADER_INDEX, index);
+        WriteLittleEndian<std::uint64_t>(header + HEADER_TEXT, text);
+        mFailed |= std::fseek(mFile, 0, SEEK_SET) != 0 ||
+                   std::fwrite(header, 1, sizeof(header), mFile) != sizeof(header);
+
+        mFailed |= std::fclose(mFile) != 0;
+        std::fclose(mIndex);
+        std::remove((mPath + ".index").c_str());
+        mFile  = nullptr;
+        mIndex = nullptr;
+        return !mFailed;
+    }
+
+    std::uint32_t GameDatabaseWriter::GetString(std::string_view text) {
+        const auto [it, added] =
+            mStringIds.try_emplace(std::string{text}, static_cast<std::uint32_t>(mStrings.size()));
+        if (added)
+            mStrings.push_back(it->first);
+        return it->second;
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "kpk.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace xt {
+    namespace {
+        // Positions are normalised so the pawn is white and on files a-d. Squares count from a1,
+        // so a pawn advances by one rank with +8.
+        constexpr const int NORTH = 8;
+        constexpr const int SIZE  = 2 * 24 * 64 * 64;
+
+        enum Result : std::uint8_t { INVALID = 0, UNKNOWN = 1, DRAW = 2, WIN = 4 };
+
+        int File(int sq) {
+            return sq & 7;
+        }
+
+        int Rank(int sq) {
+            return sq >> 3;
+        }
+
+        int Distance(int a, int b) {
+            return std::max(std::abs(File(a) - File(b)), std::abs(Rank(a) - Rank(b)));
+        }
+
+        int Index(Team us, int wk, int bk, int pawn) {
+            return wk | (bk << 6) | ((us == Team::BLACK) << 12) | (File(pawn) << 13) |
+                   ((6 - Rank(pawn)) << 15);
+        }
+
+        struct Position {
+            Team   us;
+            int    wk;
+            int    bk;
+            int    pawn;
+            Result result;
+        };
+
+        bool PawnAttacks(int pawn, int sq) {
+            return Rank(sq) == Rank(pawn) + 1 && std::abs(File(sq) - File(pawn)) == 1;
+        }
+
+        template <typename F>
+        void ForEachKingStep(int sq, F &&f) {
+            for (int df = -1; df <= 1; df++) {
+                for (int dr = -1; dr <= 1; dr++) {
+                    const int file = File(sq) + df, rank = Rank(sq) + dr;
+                    if ((df || dr) && file >= 0 && file < 8 && rank >= 0 && rank < 8)
+                        f(rank * 8 + file);
+                }
+            }
+        }
+
+        Position Classify(int index) {
+            Position pos;
+            pos.wk   = index & 63;
+            pos.bk   = (index >> 6) & 63;
+            pos.us   = (index >> 12) & 1 ? Team::BLACK : Team::WHITE;
+            pos.pawn = (6 - ((index >> 15) & 7)) * 8 + ((index >> 13) & 3);
+
+            const int promotion = pos.pawn + NORTH;
+            if (Distance(pos.wk, pos.bk) <= 1 || pos.wk == pos.pawn || pos.bk == pos.pawn ||
+                (pos.us == Team::WHITE && PawnAttacks(pos.pawn, pos.bk))) {
+                pos.result = INVALID;
+            } else if (pos.us == Team::WHITE && Rank(pos.pawn) == 6 && pos.wk != promotion &&
+                       (Distance(pos.bk, promotion) > 1 || Distance(pos.wk, promotion) == 1)) {
+                // The pawn promotes and can't be taken
+                pos.result = WIN;
+            } else if (pos.us == Team::BLACK) {
+                // Stalemate, or the black king takes an undefended pawn
+                bool canMove = false, canTake = false;
+                ForEachKingStep(pos.bk, [&](int sq) {
+                    if (Distance(sq, pos.wk) > 1 && !PawnAttacks(pos.pawn, sq))
+                        canMove = true;
+                    if (sq == pos.pawn && Distance(sq, pos.wk) > 1)
+                        canTake = true;
+                });
+
+                pos.result = !canMove || canTake ? DRAW : UNKNOWN;
+            } else {
+                pos.result = UNKNOWN;
+            }
+
+            return pos;
+        }
+
+        // The side to move wins if any move reaches a win for it, and it only loses (or draws, for
+        // black) once every move has been resolved against it
+        Result Resolve(const Position &pos, const std::vector<Position> &db) {
+            const Result good = pos.us == Team::WHITE ? WIN : DRAW;
+            const Result bad  = pos.us == Team::WHITE ? DRAW : WIN;
+            const Team   them = pos.us == Team::WHITE ? Team::BLACK : Team::WHITE;
+
+            int results = INVALID;
+            if (pos.us == Team::WHITE) {
+                ForEachKingStep(pos.wk, [&](int sq) {
+                    results |= db[Index(them, sq, pos.bk, pos.pawn)].result;
+                });
+
+                const int push = pos.pawn + NORTH;
+                if (Rank(pos.pawn) < 6 && push != pos.wk && push != pos.bk) {
+                    results |= db[Index(them, pos.wk, pos.bk, push)].result;
+
+                    const int jump = push + NORTH;
+                    if (Rank(pos.pawn) == 1 && jump != pos.wk && jump != pos.bk)
+                        results |= db[Index(them, pos.wk, pos.bk, jump)].result;
+                }
+            } else {
+                ForEachKingStep(pos.bk, [&](int sq) {
+                    results |= db[Index(them, pos.wk, sq, pos.pawn)].result;
+                });
+            }
+
+            if (results & good)
+                return good;
+            if (results & UNKNOWN)
+                return UNKNOWN;
+
+            return bad;
+        }
+
+        struct Bitbase {
+            std::uint32_t bits[SIZE / 32]{};
+
+        public:
+            Bitbase() {
+                std::vector<Position> db(SIZE);
+                for (int i = 0; i < SIZE; i++)
+                    db[i] = Classify(i);
+
+                // Keep resolving positions from their successors until nothing changes. Whatever
+                // is still unknown at that point can't be forced to a win, so it's a draw.
+                for (bool changed = true; changed;) {
+                    changed = false;
+                    for (auto &pos : db) {
+                        if (pos.result == UNKNOWN && (pos.result = Resolve(pos, db)) != UNKNOWN)
+                            changed = true;
+                    }
+                }
+
+                for (int i = 0; i < SIZE; i++)
+                    if (db[i].result == WIN)
+                        bits[i / 32] |= 1u << (i % 32);
+            }
+
+            bool IsWin(int index) const {
+                return bits[index / 32] & (1u << (index % 32));
+            }
+        };
+
+        const Bitbase &GetBitbase() {
+            static const Bitbase bitbase;
+            return bitbase;
+        }
+    } // namespace
+
+    bool Kpk::Probe(const Board &board, const Vector &pawn) {
+        const Team strong = board[pawn].team;
+        const Team weak   = strong == Team::WHITE ? Team::BLACK : Team::WHITE;
+
+        // Board rows start at the eighth rank. Flip the ranks when black has the pawn, and the
+        // files when it is on the king side.
+        const int  flipRank = strong == Team::WHITE ? 56 : 0;
+        const int  flipFile = pawn.x >= 4 ? 7 : 0;
+        const auto Square   = [&](const Vector &pos) {
+            return (pos.y * 8 + pos.x) ^ flipRank ^ flipFile;
+        };
+
+        const Team us = board.GetTurn() == strong ? Team::WHITE : Team::BLACK;
+        return GetBitbase().IsWin(
+            Index(us, Square(board.GetKing(strong)), Square(board.GetKing(weak)), Square(pawn)));
+    }
+
+    void Kpk::Initialize() {
+        GetBitbase();
+    }
+} // namespace xt
\ No newline at end of file
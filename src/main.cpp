@@ -8,13 +8,20 @@
 #include <numeric>
 #include <random>
 
+#include "book.hpp"
+#include "kpk.hpp"
+#include "nnue.hpp"
+#include "pgn.hpp"
 #include "renderer.hpp"
+#include "search.hpp"
 
 int main(int argc, char **argv) {
     srand(time(nullptr));
 
-    std::string save, load;
-    xt::Team    player = xt::Team::MAX;
+    std::string      save, load, tablebases, book, pgn = "game.pgn";
+    xt::Team         player = xt::Team::MAX;
+    xt::SearchLimits limits;
+    limits.movetime = std::chrono::milliseconds(1000);
     for (int i = 0; i < argc; i++) {
         std::string_view arg{argv[i]};
         if (arg == "-s" && i + 1 < argc)
@@ -27,8 +34,24 @@ int main(int argc, char **argv) {
             player = xt::Team::BLACK;
         if (arg == "-r")
             player = (xt::Team)(rand() % xt::Team::MAX);
+        if (arg == "-t" && i + 1 < argc)
+            limits.movetime = std::chrono::milliseconds(std::atoi(argv[++i]));
+        if (arg == "-n" && i + 1 < argc) {
+            if (auto network = xt::Network::Load(argv[++i]))
+                xt::Network::SetActive(std::move(network));
+            else
+                fmt::print("Failed to load network '{}'!\n", argv[i]);
+        }
+        if (arg == "-e" && i + 1 < argc)
+            tablebases = argv[++i];
+        if (arg == "-o" && i + 1 < argc)
+            book = argv[++i];
+        if (arg == "-p" && i + 1 < argc)
+            pgn = argv[++i];
     }
 
+    xt::Kpk::Initialize();
+
     sf::RenderWindow window(
         sf::VideoMode(xt::BoardRenderer::BOARD_SIZE, xt::BoardRenderer::BOARD_SIZE),
         "",
@@ -40,6 +63,23 @@ int main(int argc, char **argv) {
 
     xt::Board         board;
     xt::BoardRenderer renderer(board);
+    xt::Search        search;
+    xt::Book          openings;
+    std::uint64_t     thinking  = 0;
+    std::uint64_t     pondering = 0;
+    if (!tablebases.empty() && !search.SetTablebasePath(tablebases)) {
+        fmt::print("No endgame tables found in '{}'!\n", tablebases);
+        if (xt::Tablebase::CountSyzygyFiles(tablebases))
+            fmt::print("Syzygy files aren't supported, build the tables with tbgen.\n");
+    }
+    if (!book.empty() && !openings.Open(book))
+        fmt::print("Failed to open book '{}'!\n", book);
+
+    // The last position recorded, to find the move that was made whenever the board changes
+    xt::GameRecorder recorder;
+    xt::Board        recorded{board};
+    recorder.Reset(board);
+
     renderer.SetPosition(sf::Vector2f{0.f, 0.f});
     while (window.isOpen()) {
         const auto now = clock.getElapsedTime();
@@ -86,6 +126,17 @@ int main(int argc, char **argv) {
 
                     fmt::print("Load from '{}' failed!\n", load);
                 } break;
+                case sf::Keyboard::P:
+                {
+                    std::string text;
+                    recorder.Write(text);
+
+                    std::ofstream file(pgn, std::ios::binary);
+                    if (file.write(text.data(), text.size()))
+                        fmt::print("Saved game to '{}'!\n", pgn);
+                    else
+                        fmt::print("Save game to '{}' failed!\n", pgn);
+                } break;
                 default:
                     break;
                 }
@@ -119,15 +170,82 @@ int main(int argc, char **argv) {
             if (piece->team == player)
                 board.Promote(xt::Piece::QUEEN);
 
-        if (board.GetTurn() == player) {
-            const auto moves = board.GetValidMoves(board.GetTurn());
-            if (!moves.empty()) {
-                const auto &move = moves[rand() % moves.size()];
-                if (board.TryMove(move.first, move.second))
+        // Record moves once they're complete. A position no move leads to (ie a loaded save)
+        // starts a new game.
+        if (board.GetHash() != recorded.GetHash() && !board.GetPromoting()) {
+            xt::MoveList moves;
+            recorded.GenerateMoves(moves);
+
+            const auto move = std::find_if(moves.begin(), moves.end(), [&](const auto &candidate) {
+                xt::Board copy{recorded};
+                copy.MakeMove(candidate);
+                return copy.GetHash() == board.GetHash();
+            });
+            if (move != moves.end())
+                recorder.Add(recorded, *move);
+            else
+                recorder.Reset(board);
+
+            recorder.SetTag("White", player == xt::Team::WHITE ? "chess" : "Human");
+            recorder.SetTag("Black", player == xt::Team::BLACK ? "chess" : "Human");
+            switch (board.GetStatus()) {
+            case xt::Board::CHECKMATE:
+                recorder.SetResult(board.GetTurn() == xt::Team::WHITE ? "0-1" : "1-0");
+                break;
+            case xt::Board::STALEMATE:
+                recorder.SetResult("1/2-1/2");
+                break;
+            default:
+                break;
+            }
+
+            recorded = board;
+        }
+
+        // Search in the background so the window stays responsive, and drop the result if the
+        // position changed underneath it (ie a save was loaded)
+        if (board.GetTurn() == player && !board.GetPromoting()) {
+            if (!thinking && board.GetStatus() == xt::Board::ACTIVE) {
+                // Book moves are played without searching, dropping any search of a guessed reply
+                if (const auto move = openings.Pick(board)) {
+                    search.Stop();
+                    board.MakeMove(*move);
+                    renderer.UpdateTitle();
+                    pondering = 0;
+                    continue;
+                }
+
+                thinking = board.GetHash();
+                if (thinking == pondering)
+                    search.PonderHit();
+                else
+                    search.Start(board, {}, limits);
+
+                pondering = 0;
+            } else if (thinking && !search.IsSearching()) {
+                const auto move   = search.GetBestMove();
+                const auto ponder = search.GetPonderMove();
+                if (thinking == board.GetHash() && move.IsValid()) {
+                    board.MakeMove(move);
                     renderer.UpdateTitle();
+
+                    // Keep searching the expected reply while the player thinks
+                    xt::Board expected{board};
+                    if (ponder.IsValid() && expected.GetStatus() == xt::Board::ACTIVE) {
+                        expected.MakeMove(ponder);
+
+                        auto ponderLimits   = limits;
+                        ponderLimits.ponder = true;
+                        pondering           = expected.GetHash();
+                        search.Start(expected, {}, ponderLimits);
+                    }
+                }
+
+                thinking = 0;
             }
         }
     }
 
+    search.Stop();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "mmap.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace xt {
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept
+        : mData(std::exchange(other.mData, nullptr)), mSize(std::exchange(other.mSize, 0)) { }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            Close();
+            mData = std::exchange(other.mData, nullptr);
+            mSize = std::exchange(other.mSize, 0);
+        }
+
+        return *this;
+    }
+
+    bool MappedFile::Open(const std::string &path) {
+        Close();
+
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) < 0 || info.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+
+        // The mapping keeps its own reference to the file, so the descriptor can go right away
+        void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+            return false;
+
+        mData = static_cast<const std::uint8_t *>(data);
+        mSize = static_cast<std::size_t>(info.st_size);
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (mData)
+            munmap(const_cast<std::uint8_t *>(mData), mSize);
+
+        mData = nullptr;
+        mSize = 0;
+    }
+
+    bool MappedFile::IsOpen() const {
+        return mData != nullptr;
+    }
+
+    const std::uint8_t *MappedFile::GetData() const {
+        return mData;
+    }
+
+    std::size_t MappedFile::GetSize() const {
+        return mSize;
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "movepick.hpp"
+
+#include <algorithm>
+
+#include "eval.hpp"
+#include "see.hpp"
+
+namespace xt {
+    namespace {
+        int Index(const Vector &pos) {
+            return pos.y * Board::SIZE + pos.x;
+        }
+    } // namespace
+
+    MovePicker::MovePicker(const Board   &board,
+                           const Move    &hashMove,
+                           const Move   (&killers)[2],
+                           const History &history)
+        : mBoard(board), mHistory(history), mHashMove(hashMove), mKillers{killers[0], killers[1]} {
+        Score();
+    }
+
+    MovePicker::MovePicker(const Board &board, const History &history)
+        : mBoard(board), mHistory(history), mQuiescence(!board.InCheck()) {
+        Score();
+    }
+
+    void MovePicker::Score() {
+        MoveList moves;
+        mBoard.GenerateMoves(moves);
+
+        // Partition into tactical moves followed by quiet moves, dropping the hash move since it
+        // is returned on its own before anything else
+        bool hasHashMove = false;
+        for (const auto &move : moves) {
+            if (move == mHashMove)
+                hasHashMove = true;
+            else if (IsTactical(move))
+                mMoves.Add(move);
+        }
+
+        mQuiets = mMoves.Size();
+        for (const auto &move : moves)
+            if (move != mHashMove && !IsTactical(move) && !mQuiescence)
+                mMoves.Add(move);
+
+        if (!hasHashMove)
+            mHashMove = {};
+
+        for (std::size_t i = 0; i < mQuiets; i++) {
+            const auto &move     = mMoves[i];
+            const auto &attacker = mBoard[move.src];
+            const auto &victim   = mBoard[move.dest];
+
+            // En passant captures land on an empty square
+            const auto captured = victim.IsEmpty() && mBoard.IsCapture(move) ? Piece::PAWN
+                                                                              : victim.type;
+            mScores[i] = PIECE_VALUES[captured] * 8 - PIECE_VALUES[attacker.type] / 10;
+            if (move.promotion != Piece::MAX)
+                mScores[i] += PIECE_VALUES[move.promotion] * 8;
+        }
+
+        for (std::size_t i = mQuiets; i < mMoves.Size(); i++)
+            mScores[i] = mHistory[Index(mMoves[i].src)][Index(mMoves[i].dest)];
+    }
+
+    Move MovePicker::Next() {
+        switch (mStage) {
+        case Stage::HASH:
+            mStage = Stage::CAPTURES;
+            if (mHashMove.IsValid())
+                return mHashMove;
+
+            [[fallthrough]];
+        case Stage::CAPTURES:
+            while (mCurrent < mQuiets) {
+                const auto move = PickBest(mQuiets);
+                if (StaticExchange(mBoard, move) >= 0)
+                    return move;
+
+                if (!mQuiescence)
+                    mBadCaptures.Add(move);
+            }
+
+            mStage = Stage::KILLERS;
+            [[fallthrough]];
+        case Stage::KILLERS:
+            while (mKiller < 2) {
+                const auto &killer = mKillers[mKiller++];
+                const auto  found  = std::find(mMoves.begin() + mCurrent, mMoves.end(), killer);
+                if (killer.IsValid() && found != mMoves.end()) {
+                    // Move it out of the remaining quiets so it isn't returned twice
+                    const auto index = found - mMoves.begin();
+                    std::swap(mMoves[index], mMoves[mCurrent]);
+                    std::swap(mScores[index], mScores[mCurrent]);
+                    return mMoves[mCurrent++];
+                }
+            }
+
+            mStage = Stage::QUIETS;
+            [[fallthrough]];
+        case Stage::QUIETS:
+            if (mCurrent < mMoves.Size())
+                return PickBest(mMoves.Size());
+
+            mStage = Stage::BAD_CAPTURES;
+            [[fallthrough]];
+        case Stage::BAD_CAPTURES:
+            if (mBadCapture < mBadCaptures.Size())
+                return mBadCaptures[mBadCapture++];
+
+            mStage = Stage::DONE;
+            [[fallthrough]];
+        default:
+            return {};
+        }
+    }
+
+    MovePicker::Stage MovePicker::GetStage() const {
+        return mStage;
+    }
+
+    std::size_t MovePicker::GetMoveCount() const {
+        return mMoves.Size() + mHashMove.IsValid();
+    }
+
+    bool MovePicker::IsTactical(const Move &move) const {
+        return move.promotion != Piece::MAX || mBoard.IsCapture(move);
+    }
+
+    Move MovePicker::PickBest(std::size_t end) {
+        std::size_t best = mCurrent;
+        for (std::size_t i = mCurrent + 1; i < end; i++)
+            if (mScores[i] > mScores[best])
+                best = i;
+
+        std::swap(mMoves[best], mMoves[mCurrent]);
+        std::swap(mScores[best], mScores[mCurrent]);
+        return mMoves[mCurrent++];
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,382 @@
+#include "nnue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define XT_X86
+#endif
+
+namespace xt {
+    namespace {
+        constexpr const int INPUTS       = 2 * Accumulator::SIZE;
+        constexpr const int HEADER_SIZE  = 64;
+        constexpr const int WEIGHT_SHIFT = 6;  // fixed point scale of the hidden layers
+        constexpr const int OUTPUT_SCALE = 16; // output units per centipawn
+        constexpr const int ACTIVATION   = 127;
+
+        constexpr std::size_t Padded(std::size_t bytes) {
+            return (bytes + 63) / 64 * 64;
+        }
+
+        constexpr const std::size_t FEATURE_BIASES  = Accumulator::SIZE * sizeof(std::int16_t);
+        constexpr const std::size_t FEATURE_WEIGHTS = static_cast<std::size_t>(Network::FEATURES) *
+                                                      Accumulator::SIZE * sizeof(std::int16_t);
+        constexpr const std::size_t HIDDEN1_BIASES  = Network::HIDDEN * sizeof(std::int32_t);
+        constexpr const std::size_t HIDDEN1_WEIGHTS = Network::HIDDEN * INPUTS;
+        constexpr const std::size_t HIDDEN2_BIASES  = Network::HIDDEN * sizeof(std::int32_t);
+        constexpr const std::size_t HIDDEN2_WEIGHTS = Network::HIDDEN * Network::HIDDEN;
+        constexpr const std::size_t OUTPUT_BIAS     = Padded(sizeof(std::int32_t));
+        constexpr const std::size_t OUTPUT_WEIGHTS  = Padded(Network::HIDDEN);
+
+        constexpr const std::size_t FILE_SIZE = HEADER_SIZE + FEATURE_BIASES + FEATURE_WEIGHTS +
+                                                HIDDEN1_BIASES + HIDDEN1_WEIGHTS +
+                                                HIDDEN2_BIASES + HIDDEN2_WEIGHTS + OUTPUT_BIAS +
+                                                OUTPUT_WEIGHTS;
+
+        struct Header {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint32_t features;
+            std::uint32_t half;
+            std::uint32_t hidden;
+        };
+
+        // Clamps the accumulator of both perspectives, side to move first, into the 0..127 range
+        // the int8 layers expect
+        using TransformKernel = void (*)(const std::int16_t *input, std::uint8_t *output, int size);
+
+        // output = weights * input + biases, with weights stored row by row
+        using AffineKernel = void (*)(const std::uint8_t *input,
+                                      int                 inputs,
+                                      const std::int8_t  *weights,
+                                      const std::int32_t *biases,
+                                      std::int32_t       *output,
+                                      int                 outputs);
+
+        void TransformScalar(const std::int16_t *input, std::uint8_t *output, int size) {
+            for (int i = 0; i < size; i++)
+                output[i] = static_cast<std::uint8_t>(std::clamp<int>(input[i], 0, ACTIVATION));
+        }
+
+        void AffineScalar(const std::uint8_t *input,
+                          int                 inputs,
+                          const std::int8_t  *weights,
+                          const std::int32_t *biases,
+                          std::int32_t       *output,
+                          int                 outputs) {
+            for (int o = 0; o < outputs; o++) {
+                std::int32_t sum = biases[o];
+                for (int i = 0; i < inputs; i++)
+                    sum += input[i] * weights[o * inputs + i];
+
+                output[o] = sum;
+            }
+        }
+
+#ifdef XT_X86
+        __attribute__((target("sse4.1"))) void
+        TransformSse41(const std::int16_t *input, std::uint8_t *output, int size) {
+            const __m128i max = _mm_set1_epi8(ACTIVATION);
+            for (int i = 0; i < size; i += 16) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 8));
+                const __m128i packed = _mm_min_epu8(_mm_packus_epi16(a, b), max);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), packed);
+            }
+        }
+
+        __attribute__((target("sse4.1"))) void AffineSse41(const std::uint8_t *input,
+                                                           int                 inputs,
+                                                           const std::int8_t  *weights,
+                                                           const std::int32_t *biases,
+                                                           std::int32_t       *output,
+                                                           int                 outputs) {
+            const __m128i ones = _mm_set1_epi16(1);
+            for (int o = 0; o < outputs; o++) {
+                const auto *row = weights + o * inputs;
+
+                __m128i sum = _mm_setzero_si128();
+                for (int i = 0; i < inputs; i += 16) {
+                    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+                    const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(a, w), ones));
+                }
+
+                sum       = _mm_hadd_epi32(sum, sum);
+                sum       = _mm_hadd_epi32(sum, sum);
+                output[o] = _mm_cvtsi128_si32(sum) + biases[o];
+            }
+        }
+
+        __attribute__((target("avx2"))) void
+        TransformAvx2(const std::int16_t *input, std::uint8_t *output, int size) {
+            const __m256i max = _mm256_set1_epi8(ACTIVATION);
+            for (int i = 0; i < size; i += 32) {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+                const __m256i b =
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i + 16));
+
+                // packus works within 128 bit lanes, so the quarters need putting back in order
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i),
+                                    _mm256_min_epu8(packed, max));
+            }
+        }
+
+        __attribute__((target("avx2"))) void AffineAvx2(const std::uint8_t *input,
+                                                        int                 inputs,
+                                                        const std::int8_t  *weights,
+                                                        const std::int32_t *biases,
+                                                        std::int32_t       *output,
+                                                        int                 outputs) {
+            const __m256i ones = _mm256_set1_epi16(1);
+            for (int o = 0; o < outputs; o++) {
+                const auto *row = weights + o * inputs;
+
+                __m256i sum = _mm256_setzero_si256();
+                for (int i = 0; i < inputs; i += 32) {
+                    const __m256i a =
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+                    const __m256i w =
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+                    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), ones));
+                }
+
+                __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                             _mm256_extracti128_si256(sum, 1));
+                half         = _mm_hadd_epi32(half, half);
+                half         = _mm_hadd_epi32(half, half);
+                output[o]    = _mm_cvtsi128_si32(half) + biases[o];
+            }
+        }
+#endif
+
+        struct Kernels {
+            TransformKernel transform;
+            AffineKernel    affine;
+        };
+
+        constexpr const Kernels KERNELS[Network::ISA_MAX] = {
+            {TransformScalar, AffineScalar},
+#ifdef XT_X86
+            {TransformSse41, AffineSse41},
+            {TransformAvx2, AffineAvx2},
+#else
+            {TransformScalar, AffineScalar},
+            {TransformScalar, AffineScalar},
+#endif
+        };
+
+        std::uint64_t SplitMix64(std::uint64_t &state) {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z               = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z               = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Rescales a hidden layer's sums into the activation range
+        void Activate(const std::int32_t *input, std::uint8_t *output, int size) {
+            for (int i = 0; i < size; i++)
+                output[i] = static_cast<std::uint8_t>(
+                    std::clamp(input[i] >> WEIGHT_SHIFT, 0, ACTIVATION));
+        }
+
+        std::unique_ptr<Network> gActive;
+        std::atomic<std::uint32_t> gNextId{1};
+    } // namespace
+
+    std::unique_ptr<Network> Network::Load(const std::string &path) {
+        std::unique_ptr<Network> network(new Network());
+        if (!network->mFile.Open(path) ||
+            !network->Bind(network->mFile.GetData(), network->mFile.GetSize()))
+            return nullptr;
+
+        return network;
+    }
+
+    std::unique_ptr<Network> Network::CreateRandom(std::uint64_t seed) {
+        std::unique_ptr<Network> network(new Network());
+        auto                    &data = network->mOwned;
+        data.assign(FILE_SIZE, 0);
+
+        const Header header{MAGIC, VERSION, FEATURES, Accumulator::SIZE, HIDDEN};
+        std::memcpy(data.data(), &header, sizeof(header));
+
+        network->Bind(data.data(), data.size());
+
+        // Small weights keep the sums inside the ranges a real network would produce. The blocks
+        // point into mOwned, so writing through them is fine.
+        const auto Fill = [&](const auto *block, std::size_t count, int range) {
+            using Type  = std::remove_cv_t<std::remove_pointer_t<decltype(block)>>;
+            auto *write = const_cast<Type *>(block);
+            for (std::size_t i = 0; i < count; i++)
+                write[i] = static_cast<Type>(static_cast<int>(SplitMix64(seed) % (2 * range + 1)) -
+                                             range);
+        };
+
+        Fill(network->mFeatureBiases, Accumulator::SIZE, 64);
+        Fill(network->mFeatureWeights, FEATURE_WEIGHTS / sizeof(std::int16_t), 16);
+        Fill(network->mHidden1Biases, HIDDEN, 1024);
+        Fill(network->mHidden1Weights, HIDDEN1_WEIGHTS, 32);
+        Fill(network->mHidden2Biases, HIDDEN, 1024);
+        Fill(network->mHidden2Weights, HIDDEN2_WEIGHTS, 32);
+        Fill(network->mOutputWeights, HIDDEN, 32);
+        return network;
+    }
+
+    const Network *Network::GetActive() {
+        return gActive.get();
+    }
+
+    void Network::SetActive(std::unique_ptr<Network> network) {
+        gActive = std::move(network);
+    }
+
+    bool Network::IsSupported(Isa isa) {
+#ifdef XT_X86
+        if (isa == AVX2)
+            return __builtin_cpu_supports("avx2");
+        if (isa == SSE41)
+            return __builtin_cpu_supports("sse4.1");
+#endif
+
+        return isa == SCALAR;
+    }
+
+    const char *Network::GetName(Isa isa) {
+        constexpr const char *NAMES[ISA_MAX] = {"scalar", "sse4.1", "avx2"};
+        return NAMES[isa];
+    }
+
+    int Network::GetFeature(Team perspective, const Vector &king, const Piece &piece,
+                            const Vector &pos) {
+        // Black sees the board upside down, so both sides share the same weights
+        const int flip = perspective == Team::WHITE ? 0 : SQUARES - Board::SIZE;
+        const int ksq  = (king.y * Board::SIZE + king.x) ^ flip;
+        const int sq   = (pos.y * Board::SIZE + pos.x) ^ flip;
+
+        // Kings aren't features, so the remaining five types are packed together
+        const int type  = piece.type - (piece.type > Piece::KING);
+        const int index = type * 2 + (piece.team != perspective);
+        return (ksq * 10 + index) * SQUARES + sq;
+    }
+
+    std::uint32_t Network::GetId() const {
+        return mId;
+    }
+
+    Network::Isa Network::GetIsa() const {
+        return mIsa;
+    }
+
+    void Network::SetIsa(Isa isa) {
+        if (IsSupported(isa))
+            mIsa = isa;
+    }
+
+    void Network::Refresh(const Board &board, Team perspective, Accumulator &accumulator) const {
+        std::memcpy(accumulator.values[perspective], mFeatureBiases, FEATURE_BIASES);
+
+        const auto king = board.GetKing(perspective);
+        if (!board.IsValid(king))
+            return;
+
+        for (Int y = 0; y < Board::SIZE; y++) {
+            for (Int x = 0; x < Board::SIZE; x++) {
+                const auto &piece = board[{x, y}];
+                if (!piece.IsEmpty() && piece.type != Piece::KING)
+                    AddFeature(accumulator, perspective, GetFeature(perspective, king, piece, {x, y}));
+            }
+        }
+    }
+
+    void Network::AddFeature(Accumulator &accumulator, Team perspective, int feature) const {
+        const auto *weights = mFeatureWeights + static_cast<std::size_t>(feature) * Accumulator::SIZE;
+        for (int i = 0; i < Accumulator::SIZE; i++)
+            accumulator.values[perspective][i] += weights[i];
+    }
+
+    void Network::RemoveFeature(Accumulator &accumulator, Team perspective, int feature) const {
+        const auto *weights = mFeatureWeights + static_cast<std::size_t>(feature) * Accumulator::SIZE;
+        for (int i = 0; i < Accumulator::SIZE; i++)
+            accumulator.values[perspective][i] -= weights[i];
+    }
+
+    int Network::Evaluate(const Board &board) const {
+        Accumulator fresh;
+        const auto  Recompute = [&] {
+            for (const auto team : {Team::WHITE, Team::BLACK})
+                Refresh(board, team, fresh);
+            return true;
+        };
+
+        const auto &accumulator = board.GetAccumulator();
+        if (accumulator.network == mId) {
+            // Debug builds check the incremental update against a full recomputation
+            assert(Recompute() &&
+                   !std::memcmp(accumulator.values, fresh.values, sizeof(fresh.values)));
+            return Evaluate(accumulator, board.GetTurn(), mIsa);
+        }
+
+        // The board was set up before this network became active
+        Recompute();
+        return Evaluate(fresh, board.GetTurn(), mIsa);
+    }
+
+    int Network::Evaluate(const Accumulator &accumulator, Team us, Isa isa) const {
+        const auto &kernels = KERNELS[isa];
+        const Team  them    = us == Team::WHITE ? Team::BLACK : Team::WHITE;
+
+        alignas(32) std::uint8_t input[INPUTS];
+        kernels.transform(accumulator.values[us], input, Accumulator::SIZE);
+        kernels.transform(accumulator.values[them], input + Accumulator::SIZE, Accumulator::SIZE);
+
+        alignas(32) std::int32_t sums[HIDDEN];
+        alignas(32) std::uint8_t hidden1[HIDDEN];
+        alignas(32) std::uint8_t hidden2[HIDDEN];
+        kernels.affine(input, INPUTS, mHidden1Weights, mHidden1Biases, sums, HIDDEN);
+        Activate(sums, hidden1, HIDDEN);
+        kernels.affine(hidden1, HIDDEN, mHidden2Weights, mHidden2Biases, sums, HIDDEN);
+        Activate(sums, hidden2, HIDDEN);
+
+        std::int32_t output;
+        kernels.affine(hidden2, HIDDEN, mOutputWeights, mOutputBias, &output, 1);
+        return output / OUTPUT_SCALE;
+    }
+
+    bool Network::Bind(const std::uint8_t *data, std::size_t size) {
+        Header header;
+        if (size != FILE_SIZE)
+            return false;
+
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION || header.features != FEATURES ||
+            header.half != Accumulator::SIZE || header.hidden != HIDDEN)
+            return false;
+
+        const auto *cursor = data + HEADER_SIZE;
+        const auto  Next   = [&](std::size_t bytes) {
+            const auto *block = cursor;
+            cursor += bytes;
+            return block;
+        };
+
+        mFeatureBiases  = reinterpret_cast<const std::int16_t *>(Next(FEATURE_BIASES));
+        mFeatureWeights = reinterpret_cast<const std::int16_t *>(Next(FEATURE_WEIGHTS));
+        mHidden1Biases  = reinterpret_cast<const std::int32_t *>(Next(HIDDEN1_BIASES));
+        mHidden1Weights = reinterpret_cast<const std::int8_t *>(Next(HIDDEN1_WEIGHTS));
+        mHidden2Biases  = reinterpret_cast<const std::int32_t *>(Next(HIDDEN2_BIASES));
+        mHidden2Weights = reinterpret_cast<const std::int8_t *>(Next(HIDDEN2_WEIGHTS));
+        mOutputBias     = reinterpret_cast<const std::int32_t *>(Next(OUTPUT_BIAS));
+        mOutputWeights  = reinterpret_cast<const std::int8_t *>(Next(OUTPUT_WEIGHTS));
+
+        mId  = gNextId++;
+        mIsa = IsSupported(AVX2) ? AVX2 : IsSupported(SSE41) ? SSE41 : SCALAR;
+        return true;
+    }
+} // namespace xt
\ No newline at end of file
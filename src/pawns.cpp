@@ -0,0 +1,156 @@
+#include "pawns.hpp"
+
+namespace xt {
+    namespace {
+        constexpr const Score DOUBLED  = {-10, -20};
+        constexpr const Score ISOLATED = {-10, -15};
+        constexpr const Score BACKWARD = {-8, -10};
+
+        // By rank counted from the pawn's own side, the starting rank being 1
+        constexpr const Score PASSED[Board::SIZE] = {
+            {0, 0}, {5, 10}, {10, 15}, {15, 25}, {30, 45}, {50, 75}, {80, 120}, {0, 0}};
+
+        // Shelter of one file next to the king, by whether its pawn is one or two ranks ahead
+        constexpr const int SHIELD_CLOSE = 20;
+        constexpr const int SHIELD_FAR   = 10;
+        constexpr const int SHIELD_OPEN  = -15;
+
+        bool IsPawn(const Board &board, Int x, Int y, Team team) {
+            if (!board.IsValid(x, y))
+                return false;
+
+            const auto &piece = board[{x, y}];
+            return piece.type == Piece::PAWN && piece.team == team;
+        }
+
+        Team Opponent(Team team) {
+            return team == Team::WHITE ? Team::BLACK : Team::WHITE;
+        }
+
+        Int RelativeRank(Team team, Int y) {
+            return team == Team::WHITE ? Board::SIZE - 1 - y : y;
+        }
+
+        // Is there a pawn of team on file x strictly ahead of rank y, as seen from side
+        bool HasPawnAhead(const Board &board, Int x, Int y, Team side, Team team) {
+            const Int forward = side == Team::WHITE ? -1 : 1;
+            for (Int ry = y + forward; board.IsValid(x, ry); ry += forward)
+                if (IsPawn(board, x, ry, team))
+                    return true;
+
+            return false;
+        }
+
+        bool HasPawnBehind(const Board &board, Int x, Int y, Team team) {
+            const Int forward = team == Team::WHITE ? -1 : 1;
+            for (Int ry = y; board.IsValid(x, ry); ry -= forward)
+                if (IsPawn(board, x, ry, team))
+                    return true;
+
+            return false;
+        }
+
+        bool HasPawnOnFile(const Board &board, Int x, Team team) {
+            for (Int y = 0; y < Board::SIZE; y++)
+                if (IsPawn(board, x, y, team))
+                    return true;
+
+            return false;
+        }
+    } // namespace
+
+    PawnTable::PawnTable() : mEntries(std::make_unique<Entry[]>(SIZE)) {
+        // Start every slot with a key that can't index it, so nothing matches before it's written
+        for (std::size_t i = 0; i < SIZE; i++)
+            mEntries[i].key = ~static_cast<std::uint64_t>(i);
+    }
+
+    const PawnTable::Entry &PawnTable::Probe(const Board &board) {
+        const auto key   = board.GetPawnHash();
+        auto      &entry = mEntries[key & (SIZE - 1)];
+
+        mProbes++;
+        if (entry.key == key) {
+            mHits++;
+            return entry;
+        }
+
+        Compute(board, entry);
+        entry.key = key;
+        return entry;
+    }
+
+    void PawnTable::ResetStats() {
+        mProbes = mHits = 0;
+    }
+
+    std::uint64_t PawnTable::GetProbes() const {
+        return mProbes;
+    }
+
+    std::uint64_t PawnTable::GetHits() const {
+        return mHits;
+    }
+
+    void PawnTable::Compute(const Board &board, Entry &entry) {
+        entry.score = {};
+        for (Int y = 0; y < Board::SIZE; y++) {
+            for (Int x = 0; x < Board::SIZE; x++) {
+                const auto &piece = board[{x, y}];
+                if (piece.type != Piece::PAWN || piece.IsEmpty())
+                    continue;
+
+                const Team team    = piece.team;
+                const Team enemy   = Opponent(team);
+                const Int  forward = team == Team::WHITE ? -1 : 1;
+
+                Score score;
+                if (HasPawnAhead(board, x, y, team, team))
+                    score += DOUBLED;
+
+                const bool isolated = !HasPawnOnFile(board, x - 1, team) &&
+                                      !HasPawnOnFile(board, x + 1, team);
+                if (isolated)
+                    score += ISOLATED;
+
+                if (!HasPawnAhead(board, x - 1, y, team, enemy) &&
+                    !HasPawnAhead(board, x, y, team, enemy) &&
+                    !HasPawnAhead(board, x + 1, y, team, enemy))
+                    score += PASSED[RelativeRank(team, y)];
+
+                // Backward: no neighbour can come up to defend it, and advancing loses it to a pawn
+                if (!isolated && !HasPawnBehind(board, x - 1, y, team) &&
+                    !HasPawnBehind(board, x + 1, y, team) &&
+                    (IsPawn(board, x - 1, y + 2 * forward, enemy) ||
+                     IsPawn(board, x + 1, y + 2 * forward, enemy)))
+                    score += BACKWARD;
+
+                if (team == Team::WHITE)
+                    entry.score += score;
+                else
+                    entry.score -= score;
+            }
+        }
+
+        for (const auto team : {Team::WHITE, Team::BLACK}) {
+            const Int back    = team == Team::WHITE ? Board::SIZE - 1 : 0;
+            const Int forward = team == Team::WHITE ? -1 : 1;
+            for (Int file = 0; file < Board::SIZE; file++) {
+                int shelter = 0;
+                for (Int x = file - 1; x <= file + 1; x++) {
+                    if (x < 0 || x >= Board::SIZE)
+                        continue;
+
+                    if (IsPawn(board, x, back + forward, team))
+                        shelter += SHIELD_CLOSE;
+                    else if (IsPawn(board, x, back + 2 * forward, team))
+                        shelter += SHIELD_FAR;
+                    else
+                        shelter += SHIELD_OPEN;
+                }
+
+                entry.shelter[team][file] = static_cast<std::int16_t>(shelter);
+            }
+        }
+    }
+} // namespace xt
\ No newline at end of file
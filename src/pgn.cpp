@@ -0,0 +1,326 @@
+#include "pgn.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+namespace xt {
+    namespace {
+        bool IsResult(std::string_view token) {
+            return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+        }
+
+        std::size_t NextLine(std::string_view text, std::size_t pos) {
+            const auto end = text.find('\n', pos);
+            return end == std::string_view::npos ? text.size() : end + 1;
+        }
+
+        // Skips a comment that starts at pos, returning the position after it
+        std::size_t SkipComment(std::string_view text, std::size_t pos) {
+            if (text[pos] == ';')
+                return NextLine(text, pos);
+
+            const auto end = text.find('}', pos);
+            return end == std::string_view::npos ? text.size() : end + 1;
+        }
+
+        // Tags written first, in this order, whether they were set or not
+        constexpr const char *ROSTER[] = {"Event", "Site", "Date", "Round", "White", "Black"};
+
+        std::string_view Trim(std::string_view text) {
+            while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+                text.remove_prefix(1);
+            while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+                text.remove_suffix(1);
+            return text;
+        }
+    } // namespace
+
+    std::string_view PgnGame::GetText() const {
+        return mText;
+    }
+
+    std::string_view PgnGame::GetMovetext() const {
+        return mMovetext;
+    }
+
+    std::size_t PgnGame::GetTagCount() const {
+        return mTagCount;
+    }
+
+    const PgnGame::Tag &PgnGame::GetTag(std::size_t index) const {
+        return mTags[index];
+    }
+
+    std::string_view PgnGame::GetTag(std::string_view name) const {
+        for (std::size_t i = 0; i < mTagCount; i++)
+            if (mTags[i].name == name)
+                return mTags[i].value;
+        return {};
+    }
+
+    std::string_view PgnGame::GetResult() const {
+        if (const auto result = GetTag("Result"); !result.empty())
+            return result;
+
+        const auto space = mMovetext.find_last_of(" \t\r\n})");
+        const auto last  = mMovetext.substr(space == std::string_view::npos ? 0 : space + 1);
+        return IsResult(last) ? last : std::string_view{};
+    }
+
+    std::string_view PgnGame::NextMove(std::size_t &pos) const {
+        const auto text = mMovetext;
+        while (pos < text.size()) {
+            const char c = text[pos];
+            if (c == '{' || c == ';') {
+                pos = SkipComment(text, pos);
+            } else if (c == '(') {
+                // Variations nest, and may hold comments with parentheses of their own
+                for (int depth = 0; pos < text.size();) {
+                    if (text[pos] == '{' || text[pos] == ';') {
+                        pos = SkipComment(text, pos);
+                        continue;
+                    }
+
+                    const char next = text[pos++];
+                    if (next == '(')
+                        depth++;
+                    else if (next == ')' && --depth == 0)
+                        break;
+                }
+            } else if (std::isspace(static_cast<unsigned char>(c)) || c == ')') {
+                pos++;
+            } else {
+                const auto end   = std::min(text.find_first_of(" \t\r\n{}();", pos), text.size());
+                auto       token = text.substr(pos, end - pos);
+                pos              = end;
+                if (token[0] == '$' || IsResult(token))
+                    continue;
+
+                // Move numbers may run into the move that follows them, as in '12...Nf6'
+                if (std::isdigit(static_cast<unsigned char>(token[0]))) {
+                    const auto dots = token.find_first_not_of("0123456789");
+                    if (dots == std::string_view::npos)
+                        continue;
+
+                    if (token[dots] == '.') {
+                        token.remove_prefix(dots);
+                        token.remove_prefix(std::min(token.find_first_not_of('.'), token.size()));
+                    }
+                }
+
+                if (!token.empty())
+                    return token;
+            }
+        }
+
+        return {};
+    }
+
+    bool PgnGame::Setup(Board &board) const {
+        static const Board START;
+
+        const auto fen = GetTag("FEN");
+        if (fen.empty()) {
+            board = START;
+            return true;
+        }
+
+        return board.LoadFen(fen);
+    }
+
+    PgnReader::PgnReader(std::string_view text) : mText(text), mPos(FindGame(text, 0)) { }
+
+    bool PgnReader::Open(const std::string &path) {
+        if (!mFile.Open(path))
+            return false;
+
+        mText = {reinterpret_cast<const char *>(mFile.GetData()), mFile.GetSize()};
+        mPos  = FindGame(mText, 0);
+        return true;
+    }
+
+    std::string_view PgnReader::GetText() const {
+        return mText;
+    }
+
+    std::size_t PgnReader::GetPosition() const {
+        return mPos;
+    }
+
+    void PgnReader::Seek(std::size_t pos) {
+        mPos = FindGame(mText, pos);
+    }
+
+    bool PgnReader::Next(PgnGame &game) {
+        if (mPos >= mText.size())
+            return false;
+
+        const auto start = mPos;
+        game.mTagCount   = 0;
+        for (; mPos < mText.size() && mText[mPos] == '['; mPos = NextLine(mText, mPos)) {
+            const auto line  = mText.substr(mPos, NextLine(mText, mPos) - mPos);
+            const auto space = line.find(' ');
+            const auto open  = line.find('"');
+            const auto close = line.rfind('"');
+            if (space > open || open == std::string_view::npos || close == open ||
+                game.mTagCount == PgnGame::MAX_TAGS)
+                continue;
+
+            game.mTags[game.mTagCount++] = {line.substr(1, space - 1),
+                                            line.substr(open + 1, close - open - 1)};
+        }
+
+        // The movetext runs up to the next tag line
+        const auto movetext = mPos;
+        while (mPos < mText.size() && mText[mPos] != '[')
+            mPos = NextLine(mText, mPos);
+
+        game.mText     = mText.substr(start, mPos - start);
+        game.mMovetext = Trim(mText.substr(movetext, mPos - movetext));
+        return true;
+    }
+
+    std::size_t PgnReader::FindGame(std::string_view text, std::size_t pos) {
+        if (pos >= text.size())
+            return text.size();
+        if (pos && text[pos - 1] != '\n')
+            pos = NextLine(text, pos);
+
+        auto previous = std::string_view::npos;
+        if (pos)
+            previous = pos > 1 ? text.rfind('\n', pos - 2) + 1 : 0;
+
+        for (; pos < text.size(); previous = pos, pos = NextLine(text, pos))
+            if (text[pos] == '[' && (previous == std::string_view::npos || text[previous] != '['))
+                return pos;
+        return text.size();
+    }
+
+    void GameRecorder::Reset(const Board &board) {
+        mFen = board.GetFen();
+        if (mFen == Board::START_FEN)
+            mFen.clear();
+
+        mTurn      = board.GetTurn();
+        mFullMoves = board.GetFullMoves();
+        mResult    = "*";
+        mMoves.clear();
+        mSan.clear();
+        mTags.clear();
+    }
+
+    void GameRecorder::Add(const Board &board, const Move &move) {
+        if (!mSan.empty())
+            mSan += ' ';
+
+        mSan += board.GetSan(move);
+        mMoves.push_back(move);
+    }
+
+    void GameRecorder::Play(Board &board, const Move &move) {
+        Add(board, move);
+        board.MakeMove(move);
+    }
+
+    void GameRecorder::SetTag(std::string_view name, std::string_view value) {
+        if (name == "Result")
+            return SetResult(value);
+
+        for (auto &[tag, text] : mTags) {
+            if (tag == name) {
+                text = value;
+                return;
+            }
+        }
+
+        mTags.emplace_back(name, value);
+    }
+
+    void GameRecorder::SetResult(std::string_view result) {
+        mResult = result;
+    }
+
+    const std::vector<Move> &GameRecorder::GetMoves() const {
+        return mMoves;
+    }
+
+    void GameRecorder::Write(std::string &out) const {
+        const auto AddTag = [&](std::string_view name, std::string_view value) {
+            out += '[';
+            out += name;
+            out += " \"";
+            for (const char c : value) {
+                if (c == '"' || c == '\\')
+                    out += '\\';
+                out += c;
+            }
+            out += "\"]\n";
+        };
+
+        for (const auto *name : ROSTER) {
+            const auto value = GetTag(name);
+            if (!value.empty())
+                AddTag(name, value);
+            else
+                AddTag(name, std::string_view{name} == "Date" ? "????.??.??" : "?");
+        }
+
+        AddTag("Result", mResult);
+        if (!mFen.empty()) {
+            AddTag("SetUp", "1");
+            AddTag("FEN", mFen);
+        }
+
+        for (const auto &[name, value] : mTags)
+            if (std::find(std::begin(ROSTER), std::end(ROSTER), name) == std::end(ROSTER))
+                AddTag(name, value);
+
+        out += '\n';
+
+        std::size_t column = 0;
+        const auto  AddToken = [&](std::string_view token) {
+            if (column && column + 1 + token.size() >= 80) {
+                out += '\n';
+                column = 0;
+            } else if (column) {
+                out += ' ';
+                column++;
+            }
+
+            out += token;
+            column += token.size();
+        };
+
+        // Black's first move is numbered too when the game starts with it
+        auto turn = mTurn;
+        int  move = mFullMoves;
+        for (std::size_t pos = 0; pos < mSan.size();) {
+            if (turn == Team::WHITE || pos == 0) {
+                char       number[16];
+                const auto end  = std::to_chars(number, number + 10, move).ptr;
+                const auto dots = turn == Team::WHITE ? 1 : 3;
+                std::fill(end, end + dots, '.');
+                AddToken({number, static_cast<std::size_t>(end + dots - number)});
+            }
+
+            const auto end = std::min(mSan.find(' ', pos), mSan.size());
+            AddToken(std::string_view{mSan}.substr(pos, end - pos));
+            pos = end + 1;
+
+            if (turn == Team::BLACK)
+                move++;
+            turn = turn == Team::WHITE ? Team::BLACK : Team::WHITE;
+        }
+
+        AddToken(mResult);
+        out += "\n\n";
+    }
+
+    std::string_view GameRecorder::GetTag(std::string_view name) const {
+        for (const auto &[tag, value] : mTags)
+            if (tag == name)
+                return value;
+        return {};
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "posindex.hpp"
+
+#include <algorithm>
+#include <queue>
+
+#include "binary.hpp"
+
+namespace xt {
+    namespace {
+        constexpr const std::size_t HEADER_KEYS  = 8;
+        constexpr const std::size_t HEADER_TABLE = 16;
+        constexpr const std::size_t KEY_SIZE     = 16;
+
+        // Records read back from a run at a time
+        constexpr const std::size_t RUN_BATCH = 4096;
+
+        std::uint64_t ReadVarint(const std::uint8_t *&data, const std::uint8_t *end) {
+            std::uint64_t value = 0;
+            for (int shift = 0; data < end && shift < 64; shift += 7) {
+                const auto byte = *data++;
+                value |= std::uint64_t{byte & 0x7Fu} << shift;
+                if (!(byte & 0x80))
+                    break;
+            }
+
+            return value;
+        }
+
+        void WriteVarint(std::vector<std::uint8_t> &out, std::uint64_t value) {
+            for (; value >= 0x80; value >>= 7)
+                out.push_back(static_cast<std::uint8_t>(value | 0x80));
+            out.push_back(static_cast<std::uint8_t>(value));
+        }
+    } // namespace
+
+    bool PositionIndex::Open(const std::string &path) {
+        Close();
+        if (!mFile.Open(path) || mFile.GetSize() < HEADER_SIZE)
+            return Close(), false;
+
+        const auto *data = mFile.GetData();
+        const auto  size = mFile.GetSize();
+        if (ReadLittleEndian<std::uint32_t>(data) != MAGIC ||
+            ReadLittleEndian<std::uint32_t>(data + 4) != VERSION)
+            return Close(), false;
+
+        const auto keys  = ReadLittleEndian<std::uint64_t>(data + HEADER_KEYS);
+        const auto table = ReadLittleEndian<std::uint64_t>(data + HEADER_TABLE);
+        if (table < HEADER_SIZE || table > size || keys >= (size - table) / KEY_SIZE)
+            return Close(), false;
+
+        mKeys  = keys;
+        mTable = data + table;
+        return true;
+    }
+
+    void PositionIndex::Close() {
+        mFile.Close();
+        mKeys  = 0;
+        mTable = nullptr;
+    }
+
+    std::size_t PositionIndex::GetSize() const {
+        return mKeys;
+    }
+
+    std::size_t PositionIndex::Find(std::uint64_t key, std::vector<Posting> &postings) const {
+        std::size_t low = 0, high = mKeys;
+        while (low < high) {
+            const auto mid = (low + high) / 2;
+            if (ReadLittleEndian<std::uint64_t>(mTable + mid * KEY_SIZE) < key)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        if (low == mKeys || ReadLittleEndian<std::uint64_t>(mTable + low * KEY_SIZE) != key)
+            return 0;
+
+        // The next key's offset is where these postings end, and the extra entry is there for
+        // the last key
+        const auto *data  = mFile.GetData();
+        const auto  begin = ReadLittleEndian<std::uint64_t>(mTable + low * KEY_SIZE + 8);
+        const auto  end   = ReadLittleEndian<std::uint64_t>(mTable + (low + 1) * KEY_SIZE + 8);
+        if (begin > end || end > mFile.GetSize())
+            return 0;
+
+        const auto    size = postings.size();
+        std::uint64_t game = 0;
+        for (const auto *pos = data + begin; pos < data + end;) {
+            game += ReadVarint(pos, data + end);
+            const auto ply = ReadVarint(pos, data + end);
+            postings.push_back({game, static_cast<std::uint32_t>(ply)});
+        }
+
+        return postings.size() - size;
+    }
+
+    bool PositionIndexWriter::Record::operator<(const Record &other) const {
+        if (key != other.key)
+            return key < other.key;
+        return game != other.game ? game < other.game : ply < other.ply;
+    }
+
+    // Streams one sorted run back from the runs file
+    class PositionIndexWriter::RunReader {
+    public:
+        RunReader(std::FILE *file, long offset, std::size_t count)
+            : mFile(file), mOffset(offset), mLeft(count) { }
+
+        bool Next(Record &record) {
+            if (mPos == mBuffer.size()) {
+                if (!mLeft)
+                    return false;
+
+                mBuffer.resize(std::min(mLeft, RUN_BATCH));
+                std::fseek(mFile, mOffset, SEEK_SET);
+                if (std::fread(mBuffer.data(), sizeof(Record), mBuffer.size(), mFile) !=
+                    mBuffer.size())
+                    return false;
+
+                mOffset += static_cast<long>(mBuffer.size() * sizeof(Record));
+                mLeft -= mBuffer.size();
+                mPos = 0;
+            }
+
+            record = mBuffer[mPos++];
+            return true;
+        }
+
+    private:
+        std::FILE          *mFile;
+        long                mOffset;
+        std::size_t         mLeft;
+        std::vector<Record> mBuffer;
+        std::size_t         mPos{0};
+    };
+
+    PositionIndexWriter::PositionIndexWriter(std::size_t memory)
+        : mLimit(std::max<std::size_t>(memory / sizeof(Record), 1)) { }
+
+    PositionIndexWriter::~PositionIndexWriter() {
+        if (mFile)
+            std::fclose(mFile);
+        if (mRuns) {
+            std::fclose(mRuns);
+            std::remove((mPath + ".runs").c_str());
+        }
+        if (mKeys) {
+            std::fclose(mKeys);
+            std::remove((mPath + ".keys").c_str());
+        }
+    }
+
+    bool PositionIndexWriter::Open(const std::string &path) {
+        mPath = path;
+        mFile = std::fopen(path.c_str(), "wb");
+        mKeys = std::fopen((path + ".keys").c_str(), "w+b");
+        if (!mFile || !mKeys)
+            return false;
+
+        // Room for the header, which needs the offset of the key table
+        const std::uint8_t header[PositionIndex::HEADER_SIZE]{};
+        mFailed = std::fwrite(header, 1, sizeof(header), mFile) != sizeof(header);
+        mOffset = sizeof(header);
+        mCount  = 0;
+        mRecords.clear();
+        mRunOffsets.clear();
+        return !mFailed;
+    }
+
+    void PositionIndexWriter::Add(std::uint64_t key, std::uint64_t game, std::uint32_t ply) {
+        mRecords.push_back({key, game, ply});
+        if (mRecords.size() >= mLimit && !Spill())
+            mFailed = true;
+    }
+
+    bool PositionIndexWriter::Close() {
+        if (!mFile || !mKeys)
+            return false;
+
+        if (mRunOffsets.empty()) {
+            std::sort(mRecords.begin(), mRecords.end());
+            for (const auto &record : mRecords)
+                Emit(record);
+        } else {
+            if (!mRecords.empty() && !Spill())
+                mFailed = true;
+
+            std::vector<RunReader> readers;
+            for (const auto &[offset, count] : mRunOffsets)
+                readers.emplace_back(mRuns, offset, count);
+
+            using Head = std::pair<Record, std::size_t>;
+            const auto Greater = [](const Head &a, const Head &b) {
+                return b.first < a.first;
+            };
+            std::priority_queue<Head, std::vector<Head>, decltype(Greater)> heads{Greater};
+            for (std::size_t i = 0; i < readers.size(); i++)
+                if (Record record; readers[i].Next(record))
+                    heads.emplace(record, i);
+
+            while (!heads.empty()) {
+                const auto [record, i] = heads.top();
+                heads.pop();
+                if (Record next; readers[i].Next(next))
+                    heads.emplace(next, i);
+
+                Emit(record);
+            }
+        }
+
+        decltype(mRecords){}.swap(mRecords);
+        mFailed |= std::fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size();
+        mOffset += mBuffer.size();
+        mBuffer.clear();
+
+        // The keys follow the postings, along with the end of the last of them
+        const std::uint64_t table = mOffset;
+        std::uint8_t        end[KEY_SIZE]{};
+        WriteLittleEndian<std::uint64_t>(end + 8, mOffset);
+        mFailed |= std::fwrite(end, 1, sizeof(end), mKeys) != sizeof(end);
+        std::rewind(mKeys);
+        mFailed |= !CopyFile(mKeys, mFile);
+
+        std::uint8_t header[PositionIndex::HEADER_SIZE]{};
+        WriteLittleEndian<std::uint32_t>(header, PositionIndex::MAGIC);
+        WriteLittleEndian<std::uint32_t>(header + 4, PositionIndex::VERSION);
+        WriteLittleEndian<std::uint64_t>(header + HEADER_KEYS, mCount);
+        WriteLittleEndian<std::uint64_t>(header + HEADER_TABLE, table);
+        mFailed |= std::fseek(mFile, 0, SEEK_SET) != 0 ||
+                   std::fwrite(header, 1, sizeof(header), mFile) != sizeof(header);
+
+        mFailed |= std::fclose(mFile) != 0;
+        std::fclose(mKeys);
+        std::remove((mPath + ".keys").c_str());
+        mFile = nullptr;
+        mKeys = nullptr;
+        return !mFailed;
+    }
+
+    bool PositionIndexWriter::Spill() {
+        if (!mRuns && !(mRuns = std::fopen((mPath + ".runs").c_str(), "w+b")))
+            return false;
+
+        std::sort(mRecords.begin(), mRecords.end());
+
+        std::fseek(mRuns, 0, SEEK_END);
+        const long offset = std::ftell(mRuns);
+        if (std::fwrite(mRecords.data(), sizeof(Record), mRecords.size(), mRuns) !=
+            mRecords.size())
+            return false;
+
+        mRunOffsets.emplace_back(offset, mRecords.size());
+        mRecords.clear();
+        return true;
+    }
+
+    void PositionIndexWriter::Emit(const Record &record) {
+        // Only the first time a game reaches a position is kept
+        const bool added = !mCount || record.key != mLast.key;
+        if (!added && record.game == mLast.game)
+            return;
+
+        std::uint64_t game = record.game;
+        if (added) {
+            std::uint8_t entry[KEY_SIZE];
+            WriteLittleEndian<std::uint64_t>(entry, record.key);
+            WriteLittleEndian<std::uint64_t>(entry + 8, mOffset + mBuffer.size());
+            mFailed |= std::fwrite(entry, 1, sizeof(entry), mKeys) != sizeof(entry);
+            mCount++;
+        } else {
+            game -= mLast.game;
+        }
+
+        WriteVarint(mBuffer, game);
+        WriteVarint(mBuffer, record.ply);
+        mLast = record;
+
+        if (mBuffer.size() >= 1 << 20) {
+            mFailed |= std::fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size();
+            mOffset += mBuffer.size();
+            mBuffer.clear();
+        }
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "psqt.hpp"
+
+namespace xt {
+    namespace {
+        using Table = int[Board::SIZE * Board::SIZE];
+
+        constexpr const Score MATERIAL[Piece::MAX] = {
+            {1025, 936}, {0, 0}, {477, 512}, {337, 281}, {365, 297}, {82, 94}};
+
+        // Tables are laid out as seen by white, with the eighth rank first
+        constexpr const Table QUEEN_TABLE = {
+            -20, -10, -10, -5, -5, -10, -10, -20, //
+            -10, 0,   0,   0,  0,  0,   0,   -10, //
+            -10, 0,   5,   5,  5,  5,   0,   -10, //
+            -5,  0,   5,   5,  5,  5,   0,   -5,  //
+            0,   0,   5,   5,  5,  5,   0,   -5,  //
+            -10, 5,   5,   5,  5,  5,   0,   -10, //
+            -10, 0,   5,   0,  0,  0,   0,   -10, //
+            -20, -10, -10, -5, -5, -10, -10, -20, //
+        };
+
+        constexpr const Table KING_MIDGAME_TABLE = {
+            -30, -40, -40, -50, -50, -40, -40, -30, //
+            -30, -40, -40, -50, -50, -40, -40, -30, //
+            -30, -40, -40, -50, -50, -40, -40, -30, //
+            -30, -40, -40, -50, -50, -40, -40, -30, //
+            -20, -30, -30, -40, -40, -30, -30, -20, //
+            -10, -20, -20, -20, -20, -20, -20, -10, //
+            20,  20,  0,   0,   0,   0,   20,  20,  //
+            20,  30,  10,  0,   0,   10,  30,  20,  //
+        };
+
+        constexpr const Table KING_ENDGAME_TABLE = {
+            -50, -40, -30, -20, -20, -30, -40, -50, //
+            -30, -20, -10, 0,   0,   -10, -20, -30, //
+            -30, -10, 20,  30,  30,  20,  -10, -30, //
+            -30, -10, 30,  40,  40,  30,  -10, -30, //
+            -30, -10, 30,  40,  40,  30,  -10, -30, //
+            -30, -10, 20,  30,  30,  20,  -10, -30, //
+            -30, -30, 0,   0,   0,   0,   -30, -30, //
+            -50, -30, -30, -30, -30, -30, -30, -50, //
+        };
+
+        constexpr const Table ROOK_TABLE = {
+            0,  0,  0,  0,  0,  0,  0,  0,  //
+            5,  10, 10, 10, 10, 10, 10, 5,  //
+            -5, 0,  0,  0,  0,  0,  0,  -5, //
+            -5, 0,  0,  0,  0,  0,  0,  -5, //
+            -5, 0,  0,  0,  0,  0,  0,  -5, //
+            -5, 0,  0,  0,  0,  0,  0,  -5, //
+            -5, 0,  0,  0,  0,  0,  0,  -5, //
+            0,  0,  0,  5,  5,  0,  0,  0,  //
+        };
+
+        constexpr const Table KNIGHT_TABLE = {
+            -50, -40, -30, -30, -30, -30, -40, -50, //
+            -40, -20, 0,   0,   0,   0,   -20, -40, //
+            -30, 0,   10,  15,  15,  10,  0,   -30, //
+            -30, 5,   15,  20,  20,  15,  5,   -30, //
+            -30, 0,   15,  20,  20,  15,  0,   -30, //
+            -30, 5,   10,  15,  15,  10,  5,   -30, //
+            -40, -20, 0,   5,   5,   0,   -20, -40, //
+            -50, -40, -30, -30, -30, -30, -40, -50, //
+        };
+
+        constexpr const Table BISHOP_TABLE = {
+            -20, -10, -10, -10, -10, -10, -10, -20, //
+            -10, 0,   0,   0,   0,   0,   0,   -10, //
+            -10, 0,   5,   10,  10,  5,   0,   -10, //
+            -10, 5,   5,   10,  10,  5,   5,   -10, //
+            -10, 0,   10,  10,  10,  10,  0,   -10, //
+            -10, 10,  10,  10,  10,  10,  10,  -10, //
+            -10, 5,   0,   0,   0,   0,   5,   -10, //
+            -20, -10, -10, -10, -10, -10, -10, -20, //
+        };
+
+        constexpr const Table PAWN_MIDGAME_TABLE = {
+            0,  0,  0,  0,   0,   0,  0,  0,  //
+            60, 60, 60, 70,  70,  60, 60, 60, //
+            20, 20, 30, 40,  40,  30, 20, 20, //
+            5,  5,  10, 25,  25,  10, 5,  5,  //
+            0,  0,  5,  20,  20,  5,  0,  0,  //
+            5,  -5, -5, 5,   5,   -5, -5, 5,  //
+            5,  10, 10, -20, -20, 10, 10, 5,  //
+            0,  0,  0,  0,   0,   0,  0,  0,  //
+        };
+
+        constexpr const Table PAWN_ENDGAME_TABLE = {
+            0,   0,   0,   0,   0,   0,   0,   0,   //
+            120, 120, 110, 100, 100, 110, 120, 120, //
+            70,  70,  60,  50,  50,  60,  70,  70,  //
+            35,  30,  25,  20,  20,  25,  30,  35,  //
+            15,  12,  8,   5,   5,   8,   12,  15,  //
+            5,   5,   0,   0,   0,   0,   5,   5,   //
+            0,   0,   0,   0,   0,   0,   0,   0,   //
+            0,   0,   0,   0,   0,   0,   0,   0,   //
+        };
+
+        constexpr const Table *MIDGAME_TABLES[Piece::MAX] = {
+            &QUEEN_TABLE, &KING_MIDGAME_TABLE, &ROOK_TABLE, &KNIGHT_TABLE, &BISHOP_TABLE,
+            &PAWN_MIDGAME_TABLE};
+        constexpr const Table *ENDGAME_TABLES[Piece::MAX] = {
+            &QUEEN_TABLE, &KING_ENDGAME_TABLE, &ROOK_TABLE, &KNIGHT_TABLE, &BISHOP_TABLE,
+            &PAWN_ENDGAME_TABLE};
+
+        struct PieceSquareTable {
+            Score scores[Team::MAX][Piece::MAX][Board::SIZE * Board::SIZE]{};
+
+        public:
+            constexpr PieceSquareTable() {
+                for (int type = 0; type < Piece::MAX; type++) {
+                    for (int square = 0; square < Board::SIZE * Board::SIZE; square++) {
+                        // Black reads the tables upside down
+                        const int mirrored = square ^ (Board::SIZE * (Board::SIZE - 1));
+
+                        auto &white = scores[Team::WHITE][type][square];
+                        white.mg    = MATERIAL[type].mg + (*MIDGAME_TABLES[type])[square];
+                        white.eg    = MATERIAL[type].eg + (*ENDGAME_TABLES[type])[square];
+
+                        auto &black = scores[Team::BLACK][type][square];
+                        black.mg    = MATERIAL[type].mg + (*MIDGAME_TABLES[type])[mirrored];
+                        black.eg    = MATERIAL[type].eg + (*ENDGAME_TABLES[type])[mirrored];
+                    }
+                }
+            }
+        };
+
+        constexpr const PieceSquareTable TABLE;
+    } // namespace
+
+    const Score &GetPieceSquare(Team team, Piece::Type type, int square) {
+        return TABLE.scores[team][type][square];
+    }
+
+    Score ComputePieceSquares(const Board &board) {
+        Score score;
+        for (Int y = 0; y < Board::SIZE; y++) {
+            for (Int x = 0; x < Board::SIZE; x++) {
+                const auto &piece = board[{x, y}];
+                if (piece.IsEmpty())
+                    continue;
+
+                if (piece.team == Team::WHITE)
+                    score += GetPieceSquare(piece.team, piece.type, y * Board::SIZE + x);
+                else
+                    score -= GetPieceSquare(piece.team, piece.type, y * Board::SIZE + x);
+            }
+        }
+
+        return score;
+    }
+
+    int ComputePhase(const Board &board) {
+        int phase = 0;
+        for (Int y = 0; y < Board::SIZE; y++)
+            for (Int x = 0; x < Board::SIZE; x++)
+                if (!board[{x, y}].IsEmpty())
+                    phase += PHASE_WEIGHTS[board[{x, y}].type];
+
+        return phase;
+    }
+} // namespace xt
\ No newline at end of file
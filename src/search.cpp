@@ -0,0 +1,859 @@
+#include "search.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "eval.hpp"
+#include "evalcache.hpp"
+#include "movepick.hpp"
+
+namespace xt {
+    namespace {
+        int Index(const Vector &pos) {
+            return pos.y * Board::SIZE + pos.x;
+        }
+
+        // Mate scores are stored relative to the node so they stay valid at any ply
+        int ScoreToTable(int score, int ply) {
+            if (score >= SCORE_MATE_IN_MAX)
+                return score + ply;
+            if (score <= -SCORE_MATE_IN_MAX)
+                return score - ply;
+            return score;
+        }
+
+        int ScoreFromTable(int score, int ply) {
+            if (score >= SCORE_MATE_IN_MAX)
+                return score - ply;
+            if (score <= -SCORE_MATE_IN_MAX)
+                return score + ply;
+            return score;
+        }
+
+        // Endgame table values hold the distance to mate in plies, so they become mate scores
+        int ScoreFromTablebase(std::uint8_t value, int ply) {
+            if (EndgameTable::IsWin(value))
+                return SCORE_MATE - ply - (value - 1);
+            if (EndgameTable::IsLoss(value))
+                return -SCORE_MATE + ply + (value - 1);
+            return 0;
+        }
+
+        // A table win or loss becomes a draw when the fifty-move counter runs out before the next
+        // capture or pawn move, which the table's distance to zeroing counts the plies to
+        std::uint8_t ApplyFiftyMoveRule(const Tablebase &tables,
+                                        const Board     &board,
+                                        std::uint8_t     value) {
+            if (value == EndgameTable::DRAW)
+                return value;
+
+            const auto dtz = tables.ProbeDtz(board);
+            return dtz && board.GetHalfMoves() + *dtz > 100 ? EndgameTable::DRAW : value;
+        }
+
+        bool Contains(const MoveList &moves, const Move &move) {
+            return std::find(moves.begin(), moves.end(), move) != moves.end();
+        }
+
+        constexpr const int MAX_MOVES = 64;
+
+        // Late move reductions by depth and move number, growing with the log of both
+        const auto REDUCTIONS = [] {
+            std::array<std::array<int, MAX_MOVES>, MAX_PLY> table{};
+            for (int depth = 1; depth < MAX_PLY; depth++)
+                for (int moves = 1; moves < MAX_MOVES; moves++)
+                    table[depth][moves] =
+                        static_cast<int>(0.75 + std::log(depth) * std::log(moves) / 2.25);
+
+            return table;
+        }();
+
+        int GetReduction(int depth, int moveCount) {
+            return REDUCTIONS[std::min(depth, MAX_PLY - 1)][std::min(moveCount, MAX_MOVES - 1)];
+        }
+    } // namespace
+
+    struct Search::Worker {
+        Search           &search;
+        const std::size_t id;
+
+        std::atomic<std::uint64_t> nodes{0};
+        std::vector<std::uint64_t> hashes;
+
+        // Root moves already reported as better lines of the current MultiPV iteration, and the
+        // move that held the current line in the previous iteration to search first
+        MoveList excluded;
+        Move     lineMove;
+
+        Move      killers[MAX_PLY][2];
+        History   history[Team::MAX];
+        PawnTable pawns;
+        EvalCache evals;
+
+        // Triangular principal variation table: row ply holds the best line found from that ply
+        Move pv[MAX_PLY][MAX_PLY];
+        int  pvLength[MAX_PLY];
+
+        Move        bestMove;
+        Move        ponderMove;
+        int         completedDepth{0};
+        SearchStats stats;
+
+    public:
+        Worker(Search &search, std::size_t id)
+            : search(search), id(id), evals(search.mEvalCacheSize) {
+            Clear();
+        }
+
+        void Clear();
+        void Reset();
+        void Iterate();
+
+        // Searches the root with a window around the previous score, widening it on failure
+        int Aspiration(int depth, int previous);
+
+        int  AlphaBeta(const Board &board,
+                       int          alpha,
+                       int          beta,
+                       int          depth,
+                       int          ply,
+                       bool         allowNull = true);
+        int  Quiescence(const Board &board, int alpha, int beta, int ply);
+        bool IsRepetition(const Board &board) const;
+
+        // Counts the node and returns true if the search has been stopped
+        bool Visit();
+
+        // Evaluate through the thread's cache
+        int StaticEval(const Board &board);
+
+        void UpdateQuietStats(const Board    &board,
+                              const Move     &move,
+                              const MoveList &quiets,
+                              int             depth,
+                              int             ply);
+
+        std::vector<Move> GetPrincipalVariation() const;
+
+        // Search counters together with those kept by the thread's caches
+        SearchStats GetStats() const;
+    };
+
+    void Search::Worker::Clear() {
+        for (auto &team : history)
+            for (auto &from : team)
+                std::fill(std::begin(from), std::end(from), 0);
+
+        evals.Clear();
+    }
+
+    void Search::Worker::Reset() {
+        nodes.store(0, std::memory_order_relaxed);
+        hashes         = search.mHistory;
+        bestMove       = {};
+        ponderMove     = {};
+        completedDepth = 0;
+        pvLength[0]    = 0;
+        stats          = {};
+        pawns.ResetStats();
+        evals.ResetStats();
+
+        for (auto &ply : killers)
+            ply[0] = ply[1] = {};
+    }
+
+    void Search::Worker::Iterate() {
+        MoveList moves;
+        search.mRoot.GenerateMoves(moves);
+        if (!search.mTablebaseMoves.Empty())
+            moves = search.mTablebaseMoves;
+
+        const std::size_t lines =
+            std::max<std::size_t>(std::min(search.mOptions.multiPV, moves.Size()), 1);
+        std::vector<int>  scores(lines, 0);
+        std::vector<Move> previous(lines);
+
+        // Helpers start one iteration ahead of their neighbours so the threads spread out over
+        // different depths instead of racing through identical trees.
+        for (int depth = 1 + static_cast<int>(id % 2); depth <= search.mLimits.depth; depth++) {
+            // Each further line searches the root without the moves of the lines before it, so
+            // its score is that of the next best move. The table carries over between lines.
+            excluded.Clear();
+            for (std::size_t line = 0; line < lines; line++) {
+                lineMove        = previous[line];
+                // An aborted iteration's PV may be partial, or left over from an earlier search
+                const int score = Aspiration(depth, scores[line]);
+                if (search.mStop.load(std::memory_order_relaxed))
+                    return;
+
+                // A root without moves has no PV at all
+                scores[line] = score;
+                if (pvLength[0]) {
+                    previous[line] = pv[0][0];
+                    excluded.Add(pv[0][0]);
+                }
+
+                if (line == 0) {
+                    bestMove       = pvLength[0] ? pv[0][0] : Move{};
+                    ponderMove     = pvLength[0] > 1 ? pv[0][1] : Move{};
+                    completedDepth = depth;
+                }
+
+                if (id == 0 && search.mInfoCallback) {
+                    search.mInfoCallback(SearchInfo{
+                        depth,
+                        line + 1,
+                        score,
+                        search.GetNodes(),
+                        search.mTime.GetElapsed(),
+                        search.mTable.GetHashfull(),
+                        GetPrincipalVariation(),
+                        GetStats(),
+                    });
+                }
+            }
+
+            excluded.Clear();
+            if (search.mStop.load(std::memory_order_relaxed))
+                break;
+
+            // Only the main thread decides when to stop, the helpers follow through mStop. While
+            // pondering the decision is deferred until the ponder hit, unless the hit has
+            // already come in.
+            if (id == 0 && search.mTime.OnIteration(depth, bestMove, scores[0])) {
+                auto state = PONDERING;
+                if (!search.mPonder.compare_exchange_strong(state, STOP_ON_PONDER_HIT) &&
+                    state == THINKING) {
+                    search.mStop.store(true, std::memory_order_relaxed);
+                    break;
+                }
+            }
+        }
+    }
+
+    int Search::Worker::Aspiration(int depth, int previous) {
+        int delta = 25;
+        int alpha = -SCORE_INFINITE, beta = SCORE_INFINITE;
+        if (depth >= 4) {
+            alpha = std::max(previous - delta, -SCORE_INFINITE);
+            beta  = std::min(previous + delta, SCORE_INFINITE);
+        }
+
+        while (true) {
+            const int score = AlphaBeta(search.mRoot, alpha, beta, depth, 0);
+            if (search.mStop.load(std::memory_order_relaxed))
+                return score;
+
+            if (score <= alpha) {
+                stats.aspirationResearches++;
+                beta  = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -SCORE_INFINITE);
+            } else if (score >= beta) {
+                stats.aspirationResearches++;
+                beta = std::min(score + delta, SCORE_INFINITE);
+            } else {
+                return score;
+            }
+
+            delta += delta / 2;
+        }
+    }
+
+    int Search::Worker::AlphaBeta(const Board &board,
+                                  int          alpha,
+                                  int          beta,
+                                  int          depth,
+                                  int          ply,
+                                  bool         allowNull) {
+        pvLength[ply] = ply;
+
+        if (ply > 0 && (board.GetHalfMoves() >= 100 || IsRepetition(board)))
+            return 0;
+
+        if (depth <= 0)
+            return Quiescence(board, alpha, beta, ply);
+
+        if (ply >= MAX_PLY - 1)
+            return StaticEval(board);
+
+        if (Visit())
+            return 0;
+
+        // Anything searched with an open window is on the principal variation. Those nodes are
+        // never cut off by the table or pruned, so the line they return stays exact.
+        const bool pvNode = beta - alpha > 1;
+
+        TranspositionTable::Entry entry;
+        Move                      hashMove;
+        const bool                hit = search.mTable.Probe(board.GetHash(), entry);
+        if (hit) {
+            hashMove        = Move::Unpack(entry.move);
+            const int score = ScoreFromTable(entry.score, ply);
+            if (!pvNode && entry.depth >= depth &&
+                (entry.bound == TranspositionTable::EXACT ||
+                 (entry.bound == TranspositionTable::LOWER && score >= beta) ||
+                 (entry.bound == TranspositionTable::UPPER && score <= alpha)))
+                return score;
+        }
+
+        // The root entry belongs to the first line, so further lines start from their own move
+        if (ply == 0 && !excluded.Empty() && lineMove.IsValid())
+            hashMove = lineMove;
+
+        const auto &options = search.mOptions;
+
+        // Endgame tables settle the position outright, at its exact distance to mate unless the
+        // fifty-move rule draws it first
+        if (ply > 0 && search.mTablebase.GetMaxPieces()) {
+            const auto pieces = static_cast<std::size_t>(board.GetPieceCount());
+            const auto limit  = std::min(options.tablebaseLimit, search.mTablebase.GetMaxPieces());
+            if (pieces < limit || (pieces == limit && depth >= options.tablebaseDepth)) {
+                if (const auto value = search.mTablebase.Probe(board)) {
+                    stats.tablebaseHits++;
+                    return ScoreFromTablebase(
+                        ApplyFiftyMoveRule(search.mTablebase, board, *value), ply);
+                }
+            }
+        }
+
+        // A table hit carries the static evaluation along with the score
+        const bool inCheck = board.InCheck();
+        const int  eval    = inCheck ? -SCORE_INFINITE : hit ? entry.eval : StaticEval(board);
+
+        // Reverse futility: the static evaluation is so far above beta that a shallow search is
+        // not going to bring it back down
+        if (options.reverseFutility && !pvNode && !inCheck && depth <= 6 &&
+            std::abs(beta) < SCORE_MATE_IN_MAX && eval - 80 * depth >= beta) {
+            stats.reverseFutilityPrunes++;
+            return eval;
+        }
+
+        // Null move: if passing still fails high, a real move almost certainly will. Positions
+        // with only pawns left are skipped since zugzwang is common there, and two null moves
+        // are never made in a row.
+        if (options.nullMove && allowNull && !pvNode && !inCheck && depth >= 3 && eval >= beta &&
+            std::abs(beta) < SCORE_MATE_IN_MAX && board.HasNonPawnMaterial(board.GetTurn())) {
+            const int reduction = 3 + depth / 6;
+
+            Board child{board};
+            child.MakeNullMove();
+
+            hashes.push_back(board.GetHash());
+            const int score =
+                -AlphaBeta(child, -beta, -beta + 1, depth - 1 - reduction, ply + 1, false);
+            hashes.pop_back();
+
+            if (search.mStop.load(std::memory_order_relaxed))
+                return 0;
+
+            if (score >= beta) {
+                stats.nullMoveCutoffs++;
+                return score >= SCORE_MATE_IN_MAX ? beta : score;
+            }
+        }
+
+        MovePicker picker(board, hashMove, killers[ply], history[board.GetTurn()]);
+        if (!picker.GetMoveCount())
+            return inCheck ? -SCORE_MATE + ply : 0;
+
+        hashes.push_back(board.GetHash());
+
+        const int oldAlpha  = alpha;
+        int       best      = -SCORE_INFINITE;
+        int       moveCount = 0;
+        Move      bestMove;
+        MoveList  quiets;
+        for (Move move; (move = picker.Next()).IsValid();) {
+            // Earlier MultiPV lines take their moves with them, and root moves that give away
+            // the tablebase result are never searched
+            if (ply == 0 && (Contains(excluded, move) ||
+                             (!search.mTablebaseMoves.Empty() &&
+                              !Contains(search.mTablebaseMoves, move))))
+                continue;
+
+            moveCount++;
+
+            Board child{board};
+            child.MakeMove(move);
+
+            const bool quiet = !picker.IsTactical(move) && !child.InCheck();
+
+            // Futility: near the leaves, quiet moves can't lift a hopeless static evaluation
+            // above alpha. They were never searched, so they don't take a history malus either.
+            if (options.futility && !pvNode && !inCheck && quiet && moveCount > 1 && depth <= 3 &&
+                best > -SCORE_MATE_IN_MAX && eval + 100 + 120 * depth <= alpha) {
+                stats.futilityPrunes++;
+                continue;
+            }
+
+            // Principal variation search: the first move gets the full window and everything
+            // after it only has to prove it is no better, using a null window. Late quiet moves
+            // are also reduced, and anything that beats alpha is searched again in full.
+            int score;
+            if (moveCount == 1) {
+                score = -AlphaBeta(child, -beta, -alpha, depth - 1, ply + 1);
+            } else {
+                int reduction = 0;
+                if (options.lateMoveReductions && !inCheck && quiet && depth >= 3 &&
+                    moveCount > 3 && picker.GetStage() == MovePicker::QUIETS) {
+                    reduction = GetReduction(depth, moveCount) - pvNode;
+                    reduction = std::clamp(reduction, 0, depth - 2);
+                    stats.reductions += reduction > 0;
+                }
+
+                score = -AlphaBeta(child, -alpha - 1, -alpha, depth - 1 - reduction, ply + 1);
+                if (score > alpha && reduction)
+                    score = -AlphaBeta(child, -alpha - 1, -alpha, depth - 1, ply + 1);
+
+                if (score > alpha && score < beta && pvNode) {
+                    stats.pvsResearches++;
+                    score = -AlphaBeta(child, -beta, -alpha, depth - 1, ply + 1);
+                }
+            }
+
+            if (search.mStop.load(std::memory_order_relaxed)) {
+                hashes.pop_back();
+                return 0;
+            }
+
+            if (score > best) {
+                best     = score;
+                bestMove = move;
+                if (score > alpha) {
+                    alpha = score;
+
+                    pv[ply][ply] = move;
+                    for (int i = ply + 1; i < pvLength[ply + 1]; i++)
+                        pv[ply][i] = pv[ply + 1][i];
+                    pvLength[ply] = std::max(pvLength[ply + 1], ply + 1);
+
+                    if (alpha >= beta) {
+                        stats.cutoffs++;
+                        stats.firstMoveCutoffs += moveCount == 1;
+                        if (!picker.IsTactical(move))
+                            UpdateQuietStats(board, move, quiets, depth, ply);
+                        break;
+                    }
+                }
+            }
+
+            if (!picker.IsTactical(move))
+                quiets.Add(move);
+        }
+
+        hashes.pop_back();
+
+        // With moves excluded the root result is not the position's true value
+        if (ply == 0 && !excluded.Empty())
+            return best;
+
+        TranspositionTable::Entry stored;
+        stored.move  = bestMove.Pack();
+        stored.score = static_cast<std::int16_t>(ScoreToTable(best, ply));
+        stored.eval  = static_cast<std::int16_t>(eval);
+        stored.depth = static_cast<std::uint8_t>(depth);
+        stored.bound = best >= beta       ? TranspositionTable::LOWER
+                       : best > oldAlpha ? TranspositionTable::EXACT
+                                         : TranspositionTable::UPPER;
+        search.mTable.Store(board.GetHash(), stored);
+        return best;
+    }
+
+    int Search::Worker::Quiescence(const Board &board, int alpha, int beta, int ply) {
+        pvLength[ply] = ply;
+
+        if (ply >= MAX_PLY - 1)
+            return StaticEval(board);
+
+        if (Visit())
+            return 0;
+
+        TranspositionTable::Entry entry;
+        const bool                hit = search.mTable.Probe(board.GetHash(), entry);
+        if (hit) {
+            const int score = ScoreFromTable(entry.score, ply);
+            if (entry.bound == TranspositionTable::EXACT ||
+                (entry.bound == TranspositionTable::LOWER && score >= beta) ||
+                (entry.bound == TranspositionTable::UPPER && score <= alpha))
+                return score;
+        }
+
+        // Standing pat is only an option when not in check, otherwise every evasion is searched
+        const bool inCheck = board.InCheck();
+        const int  eval    = inCheck ? -SCORE_INFINITE : hit ? entry.eval : StaticEval(board);
+        int        best    = eval;
+        if (!inCheck) {
+            if (best >= beta)
+                return best;
+
+            alpha = std::max(alpha, best);
+        }
+
+        MovePicker picker(board, history[board.GetTurn()]);
+        if (inCheck && !picker.GetMoveCount())
+            return -SCORE_MATE + ply;
+
+        const int oldAlpha = alpha;
+        Move      bestMove;
+        for (Move move; (move = picker.Next()).IsValid();) {
+            Board child{board};
+            child.MakeMove(move);
+
+            const int score = -Quiescence(child, -beta, -alpha, ply + 1);
+            if (search.mStop.load(std::memory_order_relaxed))
+                return 0;
+
+            if (score > best) {
+                best = score;
+                if (score > alpha) {
+                    alpha    = score;
+                    bestMove = move;
+                    if (alpha >= beta)
+                        break;
+                }
+            }
+        }
+
+        TranspositionTable::Entry stored;
+        stored.move  = bestMove.Pack();
+        stored.score = static_cast<std::int16_t>(ScoreToTable(best, ply));
+        stored.eval  = static_cast<std::int16_t>(eval);
+        stored.depth = 0;
+        stored.bound = best >= beta       ? TranspositionTable::LOWER
+                       : best > oldAlpha ? TranspositionTable::EXACT
+                                         : TranspositionTable::UPPER;
+        search.mTable.Store(board.GetHash(), stored);
+        return best;
+    }
+
+    bool Search::Worker::Visit() {
+        // Every thread draws from a shared count on every node, so a node limit is met exactly.
+        // Only the clock is left to the periodic check.
+        const auto limit = search.mLimits.nodes;
+        if (limit && search.mNodeCount.fetch_add(1, std::memory_order_relaxed) >= limit &&
+            search.mPonder.load(std::memory_order_relaxed) == THINKING) {
+            search.mStop.store(true, std::memory_order_relaxed);
+            return true;
+        }
+
+        const auto count = nodes.load(std::memory_order_relaxed) + 1;
+        nodes.store(count, std::memory_order_relaxed);
+        if (id == 0 && !(count & (TimeManager::CHECK_INTERVAL - 1)) && search.ShouldStop())
+            search.mStop.store(true, std::memory_order_relaxed);
+
+        return search.mStop.load(std::memory_order_relaxed);
+    }
+
+    int Search::Worker::StaticEval(const Board &board) {
+        int score;
+        if (evals.Probe(board.GetHash(), score))
+            return score;
+
+        score = Evaluate(board, pawns);
+        evals.Store(board.GetHash(), score);
+        return score;
+    }
+
+    bool Search::Worker::IsRepetition(const Board &board) const {
+        const auto count = static_cast<int>(hashes.size());
+        const auto limit = std::min(board.GetHalfMoves(), count);
+        for (int i = 4; i <= limit; i += 2)
+            if (hashes[count - i] == board.GetHash())
+                return true;
+
+        return false;
+    }
+
+    void Search::Worker::UpdateQuietStats(const Board    &board,
+                                          const Move     &move,
+                                          const MoveList &quiets,
+                                          int             depth,
+                                          int             ply) {
+        if (killers[ply][0] != move) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = move;
+        }
+
+        // Reward the cutoff move and penalize the quiets tried before it. The gravity term keeps
+        // entries within HISTORY_MAX without periodic rescaling.
+        const auto Update = [&](const Move &quiet, int bonus) {
+            auto &entry = history[board.GetTurn()][Index(quiet.src)][Index(quiet.dest)];
+            entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+        };
+
+        const int bonus = std::min(depth * depth, 400);
+        Update(move, bonus);
+        for (const auto &quiet : quiets)
+            Update(quiet, -bonus);
+    }
+
+    std::vector<Move> Search::Worker::GetPrincipalVariation() const {
+        if (!bestMove.IsValid())
+            return {};
+
+        return {pv[0], pv[0] + std::max(pvLength[0], 1)};
+    }
+
+    SearchStats Search::Worker::GetStats() const {
+        auto total       = stats;
+        total.pawnProbes = pawns.GetProbes();
+        total.pawnHits   = pawns.GetHits();
+        total.evalProbes = evals.GetProbes();
+        total.evalHits   = evals.GetHits();
+        return total;
+    }
+} // namespace xt
+
+namespace xt {
+    SearchStats &SearchStats::operator+=(const SearchStats &other) {
+        cutoffs += other.cutoffs;
+        firstMoveCutoffs += other.firstMoveCutoffs;
+        nullMoveCutoffs += other.nullMoveCutoffs;
+        reductions += other.reductions;
+        futilityPrunes += other.futilityPrunes;
+        reverseFutilityPrunes += other.reverseFutilityPrunes;
+        pvsResearches += other.pvsResearches;
+        aspirationResearches += other.aspirationResearches;
+        pawnProbes += other.pawnProbes;
+        pawnHits += other.pawnHits;
+        evalProbes += other.evalProbes;
+        evalHits += other.evalHits;
+        tablebaseHits += other.tablebaseHits;
+        return *this;
+    }
+
+    double SearchStats::GetFirstMoveCutoffRate() const {
+        return cutoffs ? 100.0 * firstMoveCutoffs / cutoffs : 0.0;
+    }
+
+    double SearchStats::GetPawnHitRate() const {
+        return pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0;
+    }
+
+    double SearchStats::GetEvalHitRate() const {
+        return evalProbes ? 100.0 * evalHits / evalProbes : 0.0;
+    }
+
+    Search::Search() {
+        SetThreads(1);
+    }
+
+    Search::~Search() {
+        Stop();
+        Wait();
+    }
+
+    void Search::SetThreads(std::size_t threads) {
+        Wait();
+
+        mWorkers.clear();
+        for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); i++)
+            mWorkers.push_back(std::make_unique<Worker>(*this, i));
+    }
+
+    void Search::SetHashSize(std::size_t megabytes) {
+        Wait();
+        mTable.Resize(megabytes);
+    }
+
+    void Search::SetEvalCacheSize(std::size_t kilobytes) {
+        Wait();
+        mEvalCacheSize = kilobytes;
+
+        for (auto &worker : mWorkers)
+            worker->evals.Resize(kilobytes);
+    }
+
+    std::size_t Search::SetTablebasePath(const std::string &directory) {
+        Wait();
+        return mTablebase.Open(directory);
+    }
+
+    void Search::SetOptions(const SearchOptions &options) {
+        Wait();
+        mOptions = options;
+    }
+
+    const SearchOptions &Search::GetOptions() const {
+        return mOptions;
+    }
+
+    void Search::SetInfoCallback(InfoCallback callback) {
+        mInfoCallback = std::move(callback);
+    }
+
+    void Search::SetBestMoveCallback(BestMoveCallback callback) {
+        mBestMoveCallback = std::move(callback);
+    }
+
+    void Search::Clear() {
+        Wait();
+        mTable.Clear();
+
+        for (auto &worker : mWorkers)
+            worker->Clear();
+    }
+
+    void Search::Start(const Board                      &board,
+                       const std::vector<std::uint64_t> &history,
+                       const SearchLimits               &limits) {
+        Stop();
+        Wait();
+
+        mRoot       = board;
+        mHistory    = history;
+        mLimits     = limits;
+        mBestMove   = {};
+        mPonderMove = {};
+
+        if (mLimits.depth <= 0 || mLimits.depth >= MAX_PLY)
+            mLimits.depth = MAX_PLY - 1;
+
+        MoveList moves;
+        board.GenerateMoves(moves);
+        ProbeRoot(moves);
+        mTime.Start(limits,
+                    board.GetTurn(),
+                    mTablebaseMoves.Empty() ? moves.Size() : mTablebaseMoves.Size());
+
+        mTable.NewSearch();
+        for (auto &worker : mWorkers)
+            worker->Reset();
+
+        mNodeCount.store(0);
+        mStop.store(false);
+        mSearching.store(true);
+        mPonder.store(limits.ponder ? PONDERING : THINKING);
+        mThread = std::thread(&Search::Run, this);
+    }
+
+    void Search::Stop() {
+        mStop.store(true);
+    }
+
+    void Search::Wait() {
+        if (mThread.joinable())
+            mThread.join();
+    }
+
+    void Search::PonderHit() {
+        // Time spent pondering counts as our own, so a search that has already used up its
+        // budget finishes right away
+        if (mPonder.exchange(THINKING) == STOP_ON_PONDER_HIT)
+            mStop.store(true);
+    }
+
+    bool Search::IsSearching() const {
+        return mSearching.load();
+    }
+
+    std::size_t Search::GetThreads() const {
+        return mWorkers.size();
+    }
+
+    std::uint64_t Search::GetNodes() const {
+        std::uint64_t nodes = 0;
+        for (const auto &worker : mWorkers)
+            nodes += worker->nodes.load(std::memory_order_relaxed);
+
+        return nodes;
+    }
+
+    Move Search::GetBestMove() const {
+        return mBestMove;
+    }
+
+    Move Search::GetPonderMove() const {
+        return mPonderMove;
+    }
+
+    SearchStats Search::GetStats() const {
+        SearchStats stats;
+        for (const auto &worker : mWorkers)
+            stats += worker->GetStats();
+
+        return stats;
+    }
+
+    void Search::Run() {
+        std::vector<std::thread> helpers;
+        for (std::size_t i = 1; i < mWorkers.size(); i++)
+            helpers.emplace_back([this, i] { mWorkers[i]->Iterate(); });
+
+        mWorkers[0]->Iterate();
+        while ((mLimits.infinite || mPonder.load() != THINKING) && !mStop.load())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        mStop.store(true);
+        for (auto &helper : helpers)
+            helper.join();
+
+        // Prefer the deepest completed iteration, falling back to the main thread on ties
+        const Worker *best = mWorkers[0].get();
+        for (const auto &worker : mWorkers)
+            if (worker->completedDepth > best->completedDepth && worker->bestMove.IsValid())
+                best = worker.get();
+
+        // Without a completed iteration, any legal move is better than none
+        MoveList moves;
+        mRoot.GenerateMoves(moves);
+        mBestMove   = best->bestMove;
+        mPonderMove = best->ponderMove;
+        if (!Contains(moves, mBestMove)) {
+            const auto &fallback = mTablebaseMoves.Empty() ? moves : mTablebaseMoves;
+            mBestMove            = fallback.Empty() ? Move{} : fallback[0];
+            mPonderMove          = {};
+        }
+
+        // A PV cut short by a hash hit at the root still leaves the reply in the table
+        if (mBestMove.IsValid() && !mPonderMove.IsValid()) {
+            Board child{mRoot};
+            child.MakeMove(mBestMove);
+
+            TranspositionTable::Entry entry;
+            MoveList                  replies;
+            child.GenerateMoves(replies);
+            if (mTable.Probe(child.GetHash(), entry))
+                for (const auto &reply : replies)
+                    if (reply.Pack() == entry.move)
+                        mPonderMove = reply;
+        }
+
+        if (mBestMoveCallback)
+            mBestMoveCallback(mBestMove, mPonderMove);
+
+        mSearching.store(false);
+    }
+
+    void Search::ProbeRoot(const MoveList &moves) {
+        mTablebaseMoves.Clear();
+
+        const auto limit = std::min(mOptions.tablebaseLimit, mTablebase.GetMaxPieces());
+        if (static_cast<std::size_t>(mRoot.GetPieceCount()) > limit)
+            return;
+
+        std::uint8_t values[MoveList::CAPACITY];
+        int          best = std::numeric_limits<int>::min();
+        for (std::size_t i = 0; i < moves.Size(); i++) {
+            Board child{mRoot};
+            child.MakeMove(moves[i]);
+
+            const auto value = mTablebase.Probe(child);
+            if (!value)
+                return;
+
+            values[i] = EndgameTable::GetParent(ApplyFiftyMoveRule(mTablebase, child, *value));
+            best      = std::max(best, EndgameTable::GetRank(values[i]));
+        }
+
+        for (std::size_t i = 0; i < moves.Size(); i++)
+            if (EndgameTable::GetRank(values[i]) == best)
+                mTablebaseMoves.Add(moves[i]);
+    }
+
+    bool Search::ShouldStop() const {
+        return mPonder.load() == THINKING && mTime.IsHardLimitReached();
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "see.hpp"
+
+#include <algorithm>
+
+#include "eval.hpp"
+
+namespace xt {
+    namespace {
+        // A king can only take last, so it is worth more than anything it could win
+        constexpr const int KING_VALUE = 20000;
+
+        constexpr const Vector KNIGHT_OFFSETS[] = {
+            {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+        constexpr const Vector KING_OFFSETS[] = {
+            {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+        constexpr const Vector ROOK_DIRECTIONS[]   = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+        constexpr const Vector BISHOP_DIRECTIONS[] = {{1, 1}, {-1, 1}, {-1, -1}, {1, -1}};
+
+        int Value(Piece::Type type) {
+            return type == Piece::KING ? KING_VALUE : PIECE_VALUES[type];
+        }
+
+        struct Exchange {
+            Piece pieces[Board::SIZE * Board::SIZE];
+
+        public:
+            explicit Exchange(const Board &board) {
+                for (Int y = 0; y < Board::SIZE; y++)
+                    for (Int x = 0; x < Board::SIZE; x++)
+                        pieces[y * Board::SIZE + x] = board[{x, y}];
+            }
+
+            const Piece *At(int x, int y) const {
+                if (x < 0 || y < 0 || x >= Board::SIZE || y >= Board::SIZE)
+                    return nullptr;
+                return &pieces[y * Board::SIZE + x];
+            }
+
+            // Finds the least valuable piece of team attacking target. Pieces already removed
+            // from the exchange uncover the sliders behind them.
+            std::optional<Vector> LeastValuableAttacker(const Vector &target, Team team) const {
+                const auto Holds = [&](int x, int y, Piece::Type type) {
+                    const auto piece = At(x, y);
+                    return piece && piece->team == team && piece->type == type;
+                };
+
+                const auto pawnRow = target.y + (team == Team::WHITE ? 1 : -1);
+                for (int x = target.x - 1; x <= target.x + 1; x += 2)
+                    if (Holds(x, pawnRow, Piece::PAWN))
+                        return Vector(x, pawnRow);
+
+                for (const auto &offset : KNIGHT_OFFSETS)
+                    if (Holds(target.x + offset.x, target.y + offset.y, Piece::KNIGHT))
+                        return Vector(target.x + offset.x, target.y + offset.y);
+
+                std::optional<Vector> found;
+                int                   best = KING_VALUE + 1;
+
+                const auto Slide = [&](const Vector(&directions)[4], Piece::Type type) {
+                    for (const auto &dir : directions) {
+                        int x = target.x + dir.x, y = target.y + dir.y;
+                        for (auto piece = At(x, y); piece; piece = At(x += dir.x, y += dir.y)) {
+                            if (piece->IsEmpty())
+                                continue;
+
+                            if (piece->team == team &&
+                                (piece->type == type || piece->type == Piece::QUEEN) &&
+                                Value(piece->type) < best) {
+                                best  = Value(piece->type);
+                                found = Vector(x, y);
+                            }
+                            break;
+                        }
+                    }
+                };
+
+                Slide(BISHOP_DIRECTIONS, Piece::BISHOP);
+                Slide(ROOK_DIRECTIONS, Piece::ROOK);
+                if (found)
+                    return found;
+
+                for (const auto &offset : KING_OFFSETS)
+                    if (Holds(target.x + offset.x, target.y + offset.y, Piece::KING))
+                        return Vector(target.x + offset.x, target.y + offset.y);
+
+                return std::nullopt;
+            }
+
+            void Remove(const Vector &pos) {
+                pieces[pos.y * Board::SIZE + pos.x].Clear();
+            }
+        };
+    } // namespace
+
+    int StaticExchange(const Board &board, const Move &move) {
+        Exchange exchange(board);
+
+        const auto &mover  = board[move.src];
+        const auto &target = board[move.dest];
+
+        int gain[32];
+        int depth = 0;
+
+        gain[0] = target.IsEmpty() ? 0 : Value(target.type);
+        if (target.IsEmpty() && board.IsCapture(move)) {
+            gain[0] = PIECE_VALUES[Piece::PAWN];
+            exchange.Remove({move.dest.x, move.src.y});
+        }
+
+        // The piece standing on the square, which the next capture wins
+        int onSquare = Value(mover.type);
+        if (move.promotion != Piece::MAX) {
+            gain[0] += Value(move.promotion) - Value(Piece::PAWN);
+            onSquare = Value(move.promotion);
+        }
+
+        exchange.Remove(move.src);
+
+        Team side = mover.team == Team::WHITE ? Team::BLACK : Team::WHITE;
+        while (depth < 31) {
+            const auto attacker = exchange.LeastValuableAttacker(move.dest, side);
+            if (!attacker)
+                break;
+
+            depth++;
+            gain[depth] = onSquare - gain[depth - 1];
+
+            // Neither side can come out ahead by continuing from here
+            if (std::max(-gain[depth - 1], gain[depth]) < 0)
+                break;
+
+            onSquare = Value(exchange.At(attacker->x, attacker->y)->type);
+            exchange.Remove(*attacker);
+            side = side == Team::WHITE ? Team::BLACK : Team::WHITE;
+        }
+
+        while (depth > 0) {
+            gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+            depth--;
+        }
+
+        return gain[0];
+    }
+} // namespace xt
\ No newline at end of file
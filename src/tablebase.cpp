@@ -0,0 +1,420 @@
+#include "tablebase.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
+#include "eval.hpp"
+
+namespace xt {
+    namespace {
+        constexpr const std::uint32_t MAGIC       = 0x42545458; // 'XTTB'
+        constexpr const std::uint32_t VERSION     = 2;
+        constexpr const std::size_t   HEADER_SIZE = 64;
+
+        constexpr const char *PIECE_CHARS = "QKRNBP";
+
+        Team Opponent(Team team) {
+            return team == Team::WHITE ? Team::BLACK : Team::WHITE;
+        }
+
+        std::uint64_t GetPieceKey(Team team, Piece::Type type) {
+            return 1ull << (4 * (team * Piece::MAX + type));
+        }
+
+        std::uint64_t GetMaterialKey(const Board &board) {
+            std::uint64_t key = 0;
+            for (int sq = 0; sq < Board::SIZE * Board::SIZE; sq++) {
+                const auto &piece = board[Vector(sq % Board::SIZE, sq / Board::SIZE)];
+                if (!piece.IsEmpty() && piece.type != Piece::KING)
+                    key += GetPieceKey(piece.team, piece.type);
+            }
+            return key;
+        }
+    } // namespace
+
+    bool TableMaterial::Parse(const std::string &name, TableMaterial &material) {
+        const auto split = name.find('v');
+        if (split == std::string::npos || name[0] != 'K' || name[split + 1] != 'K')
+            return false;
+
+        const auto Side = [&](std::string_view text, std::vector<Piece::Type> &out) {
+            for (const char c : text) {
+                const auto *type = std::strchr(PIECE_CHARS, c);
+                if (!type || !c || c == 'K')
+                    return false;
+                out.push_back(static_cast<Piece::Type>(type - PIECE_CHARS));
+            }
+            return true;
+        };
+
+        material = {};
+        if (!Side(std::string_view{name}.substr(1, split - 1), material.pieces[Team::WHITE]) ||
+            !Side(std::string_view{name}.substr(split + 2), material.pieces[Team::BLACK]))
+            return false;
+
+        material.Sort();
+        return material.GetCount() <= EndgameTable::MAX_PIECES;
+    }
+
+    std::string TableMaterial::GetName() const {
+        std::string name = "K";
+        for (const auto type : pieces[Team::WHITE])
+            name += PIECE_CHARS[type];
+        name += "vK";
+        for (const auto type : pieces[Team::BLACK])
+            name += PIECE_CHARS[type];
+        return name;
+    }
+
+    std::size_t TableMaterial::GetCount() const {
+        return 2 + pieces[Team::WHITE].size() + pieces[Team::BLACK].size();
+    }
+
+    std::size_t TableMaterial::GetPawns() const {
+        std::size_t pawns = 0;
+        for (const auto &side : pieces)
+            pawns += std::count(side.begin(), side.end(), Piece::PAWN);
+        return pawns;
+    }
+
+    std::uint64_t TableMaterial::GetKey() const {
+        std::uint64_t key = 0;
+        for (const auto team : {Team::WHITE, Team::BLACK})
+            for (const auto type : pieces[team])
+                key += GetPieceKey(team, type);
+        return key;
+    }
+
+    void TableMaterial::Sort() {
+        for (auto &side : pieces)
+            std::sort(side.begin(), side.end(), [](auto a, auto b) {
+                return PIECE_VALUES[a] > PIECE_VALUES[b];
+            });
+    }
+
+    bool TableMaterial::IsCanonical() const {
+        const auto &white = pieces[Team::WHITE], &black = pieces[Team::BLACK];
+        if (white.size() != black.size())
+            return white.size() > black.size();
+
+        for (std::size_t i = 0; i < white.size(); i++)
+            if (white[i] != black[i])
+                return PIECE_VALUES[white[i]] > PIECE_VALUES[black[i]];
+        return true;
+    }
+
+    TableMaterial TableMaterial::Flipped() const {
+        TableMaterial flipped;
+        flipped.pieces[Team::WHITE] = pieces[Team::BLACK];
+        flipped.pieces[Team::BLACK] = pieces[Team::WHITE];
+        return flipped;
+    }
+
+    std::vector<TableMaterial> TableMaterial::GetConversions() const {
+        std::vector<TableMaterial> result;
+        const auto                 Add = [&](TableMaterial material) {
+            material.Sort();
+            if (material.GetCount() > 2)
+                result.push_back(material.IsCanonical() ? material : material.Flipped());
+        };
+
+        for (const auto team : {Team::WHITE, Team::BLACK}) {
+            for (std::size_t i = 0; i < pieces[team].size(); i++) {
+                auto captured = *this;
+                captured.pieces[team].erase(captured.pieces[team].begin() + i);
+                Add(captured);
+
+                if (pieces[team][i] != Piece::PAWN)
+                    continue;
+
+                for (const auto type : {Piece::QUEEN, Piece::ROOK, Piece::BISHOP, Piece::KNIGHT}) {
+                    auto promoted            = *this;
+                    promoted.pieces[team][i] = type;
+                    Add(promoted);
+                }
+            }
+        }
+        return result;
+    }
+} // namespace xt
+
+namespace xt {
+    EndgameTable::EndgameTable(const TableMaterial &material) : mMaterial(material) {
+        mPawns = material.GetPawns() != 0;
+        mPieces.push_back({Piece::KING, Team::WHITE});
+        mPieces.push_back({Piece::KING, Team::BLACK});
+        for (const auto team : {Team::WHITE, Team::BLACK})
+            for (const auto type : material.pieces[team])
+                mPieces.push_back({type, team});
+
+        mSize = 2 * GetKingSquares();
+        for (std::size_t i = 1; i < mPieces.size(); i++)
+            mSize *= 64;
+    }
+
+    bool EndgameTable::IsWin(std::uint8_t value) {
+        return value != DRAW && value != BROKEN && value % 2 == 0;
+    }
+
+    bool EndgameTable::IsLoss(std::uint8_t value) {
+        return value != BROKEN && value % 2 == 1;
+    }
+
+    std::uint8_t EndgameTable::GetParent(std::uint8_t child) {
+        return child == DRAW ? DRAW : child + 1;
+    }
+
+    int EndgameTable::GetRank(std::uint8_t value) {
+        if (IsWin(value))
+            return 1000 - value;
+        return value == DRAW ? 0 : value - 1000;
+    }
+
+    const TableMaterial &EndgameTable::GetMaterial() const {
+        return mMaterial;
+    }
+
+    const std::vector<Piece> &EndgameTable::GetPieces() const {
+        return mPieces;
+    }
+
+    std::size_t EndgameTable::GetSize() const {
+        return mSize;
+    }
+
+    std::size_t EndgameTable::Encode(Team turn, Squares squares) const {
+        Normalize(squares);
+        return GetIndex(turn, squares);
+    }
+
+    Team EndgameTable::Decode(std::size_t index, Squares &squares) const {
+        for (std::size_t i = mPieces.size() - 1; i > 0; i--, index /= 64)
+            squares[i] = index % 64;
+
+        squares[0] = GetKingSquare(index % GetKingSquares());
+        return static_cast<Team>(index / GetKingSquares());
+    }
+
+    std::size_t EndgameTable::Locate(const Board &board, bool flip) const {
+        Squares squares{};
+        bool    used[64]{};
+        for (std::size_t i = 0; i < mPieces.size(); i++) {
+            const auto team = flip ? Opponent(mPieces[i].team) : mPieces[i].team;
+            for (int sq = 0; sq < 64; sq++) {
+                const auto &piece = board[Vector(sq & 7, sq >> 3)];
+                if (used[sq] || piece.type != mPieces[i].type || piece.team != team)
+                    continue;
+
+                used[sq]   = true;
+                squares[i] = flip ? sq ^ 56 : sq;
+                break;
+            }
+        }
+
+        return Encode(flip ? Opponent(board.GetTurn()) : board.GetTurn(), squares);
+    }
+
+    std::uint8_t EndgameTable::Probe(const Board &board, bool flip) const {
+        return Get(Locate(board, flip));
+    }
+
+    std::uint8_t EndgameTable::Get(std::size_t index) const {
+        // Tables under construction are read while other threads write to them
+        return __atomic_load_n(&mData[index], __ATOMIC_RELAXED);
+    }
+
+    std::uint8_t EndgameTable::GetDtz(std::size_t index) const {
+        return __atomic_load_n(&mData[mSize + index], __ATOMIC_RELAXED);
+    }
+
+    void EndgameTable::Allocate() {
+        mValues.assign(2 * mSize, DRAW);
+        mData = mValues.data();
+    }
+
+    std::uint8_t *EndgameTable::GetValues() {
+        return mValues.data();
+    }
+
+    std::uint8_t *EndgameTable::GetDtzValues() {
+        return mValues.data() + mSize;
+    }
+
+    bool EndgameTable::Open(const std::string &path) {
+        if (!mFile.Open(path) || mFile.GetSize() != HEADER_SIZE + 2 * mSize) {
+            mFile.Close();
+            return false;
+        }
+
+        const auto   *header = mFile.GetData();
+        std::uint32_t magic, version;
+        std::memcpy(&magic, header, 4);
+        std::memcpy(&version, header + 4, 4);
+        if (magic != MAGIC || version != VERSION ||
+            mMaterial.GetName() != reinterpret_cast<const char *>(header + 8)) {
+            mFile.Close();
+            return false;
+        }
+
+        mValues = {};
+        mData   = header + HEADER_SIZE;
+        return true;
+    }
+
+    bool EndgameTable::Save(const std::string &path) const {
+        std::uint8_t header[HEADER_SIZE]{};
+        std::memcpy(header, &MAGIC, 4);
+        std::memcpy(header + 4, &VERSION, 4);
+        std::strncpy(reinterpret_cast<char *>(header + 8), mMaterial.GetName().c_str(), 15);
+
+        auto *file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+
+        const bool ok = std::fwrite(header, 1, HEADER_SIZE, file) == HEADER_SIZE &&
+                        std::fwrite(mData, 1, 2 * mSize, file) == 2 * mSize;
+        return std::fclose(file) == 0 && ok;
+    }
+
+    int EndgameTable::Transpose(int sq) {
+        return (7 - (sq & 7)) * 8 + 7 - (sq >> 3);
+    }
+
+    void EndgameTable::Transform(Squares &squares, int (*f)(int)) const {
+        for (std::size_t i = 0; i < mPieces.size(); i++)
+            squares[i] = f(squares[i]);
+    }
+
+    void EndgameTable::Normalize(Squares &squares) const {
+        if ((squares[0] & 7) > 3)
+            Transform(squares, [](int sq) {
+                return sq ^ 7;
+            });
+
+        if (mPawns)
+            return;
+
+        if ((squares[0] >> 3) < 4)
+            Transform(squares, [](int sq) {
+                return sq ^ 56;
+            });
+
+        if (7 - (squares[0] >> 3) > (squares[0] & 7))
+            Transform(squares, Transpose);
+    }
+
+    std::size_t EndgameTable::GetIndex(Team turn, const Squares &squares) const {
+        std::size_t index = turn * GetKingSquares() + GetKingIndex(squares[0]);
+        for (std::size_t i = 1; i < mPieces.size(); i++)
+            index = index * 64 + squares[i];
+        return index;
+    }
+
+    std::size_t EndgameTable::GetKingSquares() const {
+        return mPawns ? 32 : 10;
+    }
+
+    std::size_t EndgameTable::GetKingIndex(int sq) const {
+        if (mPawns)
+            return (sq >> 3) * 4 + (sq & 7);
+
+        const int file = sq & 7, rank = 7 - (sq >> 3);
+        return file * (file + 1) / 2 + rank;
+    }
+
+    int EndgameTable::GetKingSquare(std::size_t index) const {
+        if (mPawns)
+            return (index / 4) * 8 + index % 4;
+
+        int file = 0;
+        while (index >= static_cast<std::size_t>(file + 1)) {
+            index -= file + 1;
+            file++;
+        }
+        return (7 - static_cast<int>(index)) * 8 + file;
+    }
+} // namespace xt
+
+namespace xt {
+    std::size_t Tablebase::Open(const std::string &directory) {
+        Close();
+
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+            TableMaterial material;
+            if (entry.path().extension() != ".xtb" ||
+                !TableMaterial::Parse(entry.path().stem().string(), material) ||
+                !material.IsCanonical())
+                continue;
+
+            auto table = std::make_unique<EndgameTable>(material);
+            if (table->Open(entry.path().string()))
+                Add(std::move(table));
+        }
+
+        return mTables.size();
+    }
+
+    std::size_t Tablebase::CountSyzygyFiles(const std::string &directory) {
+        std::size_t     count = 0;
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+            const auto extension = entry.path().extension();
+            count += extension == ".rtbw" || extension == ".rtbz";
+        }
+
+        return count;
+    }
+
+    void Tablebase::Close() {
+        mIndex.clear();
+        mTables.clear();
+        mMaxPieces = 0;
+    }
+
+    void Tablebase::Add(std::unique_ptr<EndgameTable> table) {
+        const auto &material = table->GetMaterial();
+        mIndex[material.Flipped().GetKey()] = {table.get(), true};
+        mIndex[material.GetKey()]           = {table.get(), false};
+
+        mMaxPieces = std::max(mMaxPieces, material.GetCount());
+        mTables.push_back(std::move(table));
+    }
+
+    const EndgameTable *Tablebase::Find(const TableMaterial &material) const {
+        const auto it = mIndex.find(material.GetKey());
+        return it != mIndex.end() && !it->second.second ? it->second.first : nullptr;
+    }
+
+    std::size_t Tablebase::GetMaxPieces() const {
+        return mMaxPieces;
+    }
+
+    std::optional<std::uint8_t> Tablebase::Probe(const Board &board) const {
+        const auto key = GetMaterialKey(board);
+        if (!key)
+            return EndgameTable::DRAW;
+
+        const auto it = mIndex.find(key);
+        if (it == mIndex.end())
+            return std::nullopt;
+
+        return it->second.first->Probe(board, it->second.second);
+    }
+
+    std::optional<std::uint8_t> Tablebase::ProbeDtz(const Board &board) const {
+        const auto key = GetMaterialKey(board);
+        if (!key)
+            return EndgameTable::DRAW;
+
+        const auto it = mIndex.find(key);
+        if (it == mIndex.end())
+            return std::nullopt;
+
+        const auto &[table, flip] = it->second;
+        return table->GetDtz(table->Locate(board, flip));
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "timeman.hpp"
+
+#include <algorithm>
+
+#include "search.hpp"
+
+namespace xt {
+    namespace {
+        // Share of the soft limit to use after 0, 1, 2, ... iterations with the same best move
+        constexpr const double STABILITY_SCALE[] = {2.0, 1.4, 1.1, 0.9, 0.75};
+    } // namespace
+
+    bool SearchLimits::HasClock() const {
+        return time[Team::WHITE].count() || time[Team::BLACK].count();
+    }
+
+    void TimeManager::Start(const SearchLimits &limits, Team us, std::size_t legalMoves) {
+        mStart     = std::chrono::steady_clock::now();
+        mTimed     = !limits.infinite && (limits.movetime.count() || limits.HasClock());
+        mFixed     = mTimed && limits.movetime.count();
+        mForced    = mTimed && legalMoves == 1;
+        mBest      = {};
+        mStability = 0;
+
+        if (limits.movetime.count()) {
+            mSoft = mHard = std::max(limits.movetime - MOVE_OVERHEAD, limits.movetime / 2);
+        } else if (limits.HasClock()) {
+            const auto remaining = std::max(limits.time[us] - MOVE_OVERHEAD,
+                                            std::chrono::milliseconds(1));
+            const int  moves     = limits.movestogo ? std::min(limits.movestogo, 50) : 30;
+
+            // Aim to spend an even share of what is left, and never risk more than a large part
+            // of the remaining time on one move
+            const auto share = remaining / moves + limits.increment[us] * 3 / 4;
+            mSoft            = std::min(share, remaining / 2);
+            mHard            = std::min(share * 4, remaining * 4 / 5);
+        }
+    }
+
+    bool TimeManager::OnIteration(int depth, const Move &best, int score) {
+        mStability = best == mBest ? std::min(mStability + 1, 4) : 0;
+        mBest      = best;
+
+        if (mForced)
+            return true;
+
+        // A mate that the search has had enough depth to prove won't change with more time
+        if (std::abs(score) >= SCORE_MATE_IN_MAX && mTimed &&
+            depth >= 2 * (SCORE_MATE - std::abs(score)) + 2)
+            return true;
+
+        if (!mTimed)
+            return false;
+
+        if (mFixed)
+            return GetElapsed() >= mSoft;
+
+        return GetElapsed() >= mSoft * STABILITY_SCALE[mStability];
+    }
+
+    bool TimeManager::IsHardLimitReached() const {
+        return mTimed && GetElapsed() >= mHard;
+    }
+
+    std::chrono::milliseconds TimeManager::GetElapsed() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - mStart);
+    }
+
+    std::chrono::milliseconds TimeManager::GetSoftLimit() const {
+        return mSoft;
+    }
+
+    std::chrono::milliseconds TimeManager::GetHardLimit() const {
+        return mHard;
+    }
+} // namespace xt
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "tt.hpp"
+
+#include <algorithm>
+
+namespace xt {
+    namespace {
+        constexpr const std::uint8_t GENERATION_MASK = 0x3F;
+    } // namespace
+
+    TranspositionTable::TranspositionTable(std::size_t megabytes) {
+        Resize(megabytes);
+    }
+
+    void TranspositionTable::Resize(std::size_t megabytes) {
+        mSize  = std::max<std::size_t>(megabytes * 1024 * 1024 / sizeof(Slot), 1);
+        mSlots = std::make_unique<Slot[]>(mSize);
+        Clear();
+    }
+
+    void TranspositionTable::Clear() {
+        for (std::size_t i = 0; i < mSize; i++) {
+            mSlots[i].key.store(0, std::memory_order_relaxed);
+            mSlots[i].data.store(0, std::memory_order_relaxed);
+        }
+
+        mGeneration = 0;
+    }
+
+    void TranspositionTable::NewSearch() {
+        mGeneration = (mGeneration + 1) & GENERATION_MASK;
+    }
+
+    bool TranspositionTable::Probe(std::uint64_t key, Entry &entry) const {
+        const auto &slot = GetSlot(key);
+        const auto  data = slot.data.load(std::memory_order_relaxed);
+        if ((slot.key.load(std::memory_order_relaxed) ^ data) != key || !data)
+            return false;
+
+        entry = Unpack(data);
+        return true;
+    }
+
+    void TranspositionTable::Store(std::uint64_t key, const Entry &entry) {
+        auto      &slot = GetSlot(key);
+        const auto old  = slot.data.load(std::memory_order_relaxed);
+        const bool same = (slot.key.load(std::memory_order_relaxed) ^ old) == key;
+
+        // Keep deeper entries from the current search unless the new one is exact
+        const auto previous = Unpack(old);
+        if (!same && old && ((old >> 58) & GENERATION_MASK) == mGeneration &&
+            previous.depth > entry.depth + 2 && entry.bound != Bound::EXACT)
+            return;
+
+        auto stored = entry;
+        if (same && !stored.move)
+            stored.move = previous.move;
+
+        const auto data = Pack(stored, mGeneration);
+        slot.key.store(key ^ data, std::memory_order_relaxed);
+        slot.data.store(data, std::memory_order_relaxed);
+    }
+
+    int TranspositionTable::GetHashfull() const {
+        int used = 0;
+        for (std::size_t i = 0; i < std::min<std::size_t>(1000, mSize); i++) {
+            const auto data = mSlots[i].data.load(std::memory_order_relaxed);
+            used += data && ((data >> 58) & GENERATION_MASK) == mGeneration;
+        }
+
+        return used * 1000 / static_cast<int>(std::min<std::size_t>(1000, mSize));
+    }
+
+    std::uint64_t TranspositionTable::Pack(const Entry &entry, std::uint8_t generation) {
+        return static_cast<std::uint64_t>(entry.move) |
+               static_cast<std::uint64_t>(static_cast<std::uint16_t>(entry.score)) << 16 |
+               static_cast<std::uint64_t>(static_cast<std::uint16_t>(entry.eval)) << 32 |
+               static_cast<std::uint64_t>(entry.depth) << 48 |
+               static_cast<std::uint64_t>(entry.bound) << 56 |
+               static_cast<std::uint64_t>(generation & GENERATION_MASK) << 58;
+    }
+
+    TranspositionTable::Entry TranspositionTable::Unpack(std::uint64_t data) {
+        Entry entry;
+        entry.move  = static_cast<std::uint16_t>(data);
+        entry.score = static_cast<std::int16_t>(data >> 16);
+        entry.eval  = static_cast<std::int16_t>(data >> 32);
+        entry.depth = static_cast<std::uint8_t>(data >> 48);
+        entry.bound = static_cast<Bound>((data >> 56) & 3);
+        return entry;
+    }
+
+    TranspositionTable::Slot &TranspositionTable::GetSlot(std::uint64_t key) const {
+        // Map the key onto the table without a modulo by taking the high half of the product
+        const auto index = static_cast<std::size_t>(
+            (static_cast<unsigned __int128>(key) * static_cast<unsigned __int128>(mSize)) >> 64);
+        return mSlots[index];
+    }
+} // namespace xt
\ No newline at end of file
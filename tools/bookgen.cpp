@@ -0,0 +1,520 @@
+#include <fmt/format.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "board.hpp"
+#include "book.hpp"
+#include "gamedb.hpp"
+#include "pgn.hpp"
+
+namespace {
+    using xt::Board;
+    using xt::Book;
+    using xt::Piece;
+    using xt::Team;
+
+    // Shards split the keys by their top bits, so writing the shards in order writes a sorted book
+    constexpr const int         SHARD_BITS = 6;
+    constexpr const std::size_t SHARDS     = 1 << SHARD_BITS;
+
+    // Records a worker collects for one shard before taking its lock
+    constexpr const std::size_t BATCH_SIZE = 4096;
+
+    // Rough cost of one aggregated entry in a shard's hash table
+    constexpr const std::size_t ENTRY_BYTES = 64;
+
+    struct Counts {
+        std::uint32_t games{0};
+        std::uint32_t wins{0};
+        std::uint32_t draws{0};
+
+    public:
+        Counts &operator+=(const Counts &other) {
+            games += other.games;
+            wins += other.wins;
+            draws += other.draws;
+            return *this;
+        }
+    };
+
+    struct Key {
+        std::uint64_t key{0};
+        std::uint16_t move{0};
+
+    public:
+        bool operator==(const Key &other) const {
+            return key == other.key && move == other.move;
+        }
+
+        bool operator<(const Key &other) const {
+            return key != other.key ? key < other.key : move < other.move;
+        }
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key &key) const {
+            return key.key ^ (key.move * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    struct Record {
+        Key    key;
+        Counts counts;
+    };
+
+    std::size_t GetShard(std::uint64_t key) {
+        return key >> (64 - SHARD_BITS);
+    }
+
+    long GetPeakRss() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024;
+    }
+
+    // Sorts records and folds together the ones for the same position and move
+    void Combine(std::vector<Record> &records) {
+        std::sort(records.begin(), records.end(), [](const auto &a, const auto &b) {
+            return a.key < b.key;
+        });
+
+        std::size_t size = 0;
+        for (const auto &record : records) {
+            if (size && records[size - 1].key == record.key)
+                records[size - 1].counts += record.counts;
+            else
+                records[size++] = record;
+        }
+
+        records.resize(size);
+    }
+
+    // Streams one sorted run back from a spill file
+    class RunReader {
+    public:
+        RunReader(std::FILE *file, long offset, std::size_t count)
+            : mFile(file), mOffset(offset), mLeft(count) { }
+
+        bool Next(Record &record) {
+            if (mPos == mBuffer.size()) {
+                if (!mLeft)
+                    return false;
+
+                mBuffer.resize(std::min<std::size_t>(mLeft, BATCH_SIZE));
+                std::fseek(mFile, mOffset, SEEK_SET);
+                if (std::fread(mBuffer.data(), sizeof(Record), mBuffer.size(), mFile) !=
+                    mBuffer.size())
+                    return false;
+
+                mOffset += static_cast<long>(mBuffer.size() * sizeof(Record));
+                mLeft -= mBuffer.size();
+                mPos = 0;
+            }
+
+            record = mBuffer[mPos++];
+            return true;
+        }
+
+    private:
+        std::FILE          *mFile;
+        long                mOffset;
+        std::size_t         mLeft;
+        std::vector<Record> mBuffer;
+        std::size_t         mPos{0};
+    };
+
+    // Totals for one range of keys. When the table outgrows its share of the memory budget it is
+    // written out as a sorted run and cleared, and the runs are merged back when the book is
+    // written.
+    class Shard {
+    public:
+        ~Shard() {
+            if (mFile) {
+                std::fclose(mFile);
+                std::remove(mPath.c_str());
+            }
+        }
+
+        void Add(const std::vector<Record> &records, std::size_t limit, const std::string &path) {
+            std::lock_guard lock{mMutex};
+            for (const auto &record : records)
+                mTable[record.key] += record.counts;
+
+            if (mTable.size() > limit && !Spill(path))
+                mFailed = true;
+        }
+
+        std::size_t GetRuns() const {
+            return mRuns.size();
+        }
+
+        // Calls f with every (key, move) total in order
+        template <typename F>
+        bool Drain(const std::string &path, F &&f) {
+            if (mFailed)
+                return false;
+
+            if (mRuns.empty()) {
+                std::vector<Record> records;
+                records.reserve(mTable.size());
+                for (const auto &[key, counts] : mTable)
+                    records.push_back({key, counts});
+                decltype(mTable){}.swap(mTable);
+
+                std::sort(records.begin(), records.end(), [](const auto &a, const auto &b) {
+                    return a.key < b.key;
+                });
+                for (const auto &record : records)
+                    f(record);
+                return true;
+            }
+
+            if (!mTable.empty() && !Spill(path))
+                return false;
+
+            std::vector<RunReader> readers;
+            for (const auto &[offset, count] : mRuns)
+                readers.emplace_back(mFile, offset, count);
+
+            using Head = std::pair<Record, std::size_t>;
+            const auto Greater = [](const Head &a, const Head &b) {
+                return b.first.key < a.first.key;
+            };
+            std::priority_queue<Head, std::vector<Head>, decltype(Greater)> heads{Greater};
+            for (std::size_t i = 0; i < readers.size(); i++)
+                if (Record record; readers[i].Next(record))
+                    heads.emplace(record, i);
+
+            std::optional<Record> current;
+            while (!heads.empty()) {
+                auto [record, i] = heads.top();
+                heads.pop();
+                if (Record next; readers[i].Next(next))
+                    heads.emplace(next, i);
+
+                if (current && current->key == record.key) {
+                    current->counts += record.counts;
+                } else {
+                    if (current)
+                        f(*current);
+                    current = record;
+                }
+            }
+
+            if (current)
+                f(*current);
+            return true;
+        }
+
+    private:
+        bool Spill(const std::string &path) {
+            if (!mFile) {
+                mPath = path;
+                mFile = std::fopen(mPath.c_str(), "w+b");
+                if (!mFile) {
+                    fmt::print(stderr, "could not create '{}'\n", mPath);
+                    return false;
+                }
+            }
+
+            std::vector<Record> records;
+            records.reserve(mTable.size());
+            for (const auto &[key, counts] : mTable)
+                records.push_back({key, counts});
+            decltype(mTable){}.swap(mTable);
+
+            std::sort(records.begin(), records.end(), [](const auto &a, const auto &b) {
+                return a.key < b.key;
+            });
+
+            std::fseek(mFile, 0, SEEK_END);
+            const long offset = std::ftell(mFile);
+            if (std::fwrite(records.data(), sizeof(Record), records.size(), mFile) !=
+                records.size()) {
+                fmt::print(stderr, "could not write '{}'\n", mPath);
+                return false;
+            }
+
+            mRuns.emplace_back(offset, records.size());
+            return true;
+        }
+
+    private:
+        std::mutex                                mMutex;
+        std::unordered_map<Key, Counts, KeyHash>  mTable;
+        std::string                               mPath;
+        std::FILE                                *mFile{nullptr};
+        std::vector<std::pair<long, std::size_t>> mRuns;
+        bool                                      mFailed{false};
+    };
+
+    struct Options {
+        std::string output   = "book.bin";
+        int         plies    = 20;
+        std::size_t minGames = 3;
+        std::size_t memory   = 1024;
+        std::size_t threads  = std::max(1u, std::thread::hardware_concurrency());
+    };
+
+    struct Totals {
+        std::atomic<std::size_t> games{0};
+        std::atomic<std::size_t> skipped{0};
+        std::atomic<std::size_t> illegal{0};
+        std::atomic<std::size_t> positions{0};
+    };
+
+    // Replays the games starting in text[begin, end) into the shards
+    void Ingest(std::string_view    text,
+                std::size_t         begin,
+                std::size_t         end,
+                const Options      &options,
+                std::vector<Shard> &shards,
+                const std::string  &spill,
+                Totals             &totals) {
+        const std::size_t   limit = options.memory * 1024 * 1024 / ENTRY_BYTES / SHARDS;
+        std::vector<Record> batches[SHARDS];
+        for (auto &batch : batches)
+            batch.reserve(BATCH_SIZE);
+
+        const auto Flush = [&](std::size_t shard) {
+            Combine(batches[shard]);
+            shards[shard].Add(batches[shard], limit, fmt::format("{}.{}", spill, shard));
+            batches[shard].clear();
+        };
+
+        xt::PgnReader reader{text};
+        xt::PgnGame   game;
+        Board         board;
+        std::size_t   games = 0, skipped = 0, illegal = 0, positions = 0;
+        for (reader.Seek(begin); reader.GetPosition() < end && reader.Next(game);) {
+            games++;
+
+            // Points for white, in halves
+            const auto result = xt::GameDatabase::ParseResult(game.GetResult());
+            if (result == xt::GameDatabase::UNFINISHED) {
+                skipped++;
+                continue;
+            }
+
+            const int score = result == xt::GameDatabase::WHITE_WON   ? 2
+                              : result == xt::GameDatabase::BLACK_WON ? 0
+                                                                      : 1;
+
+            // A game with an illegal move still counts up to it
+            int        plies = 0;
+            const bool legal = game.Replay(board, [&](const Board &position, const xt::Move &move) {
+                const int  points = position.GetTurn() == Team::WHITE ? score : 2 - score;
+                const auto key    = Book::GetKey(position);
+                const auto shard  = GetShard(key);
+                batches[shard].push_back({{key, Book::EncodeMove(position, move)},
+                                          {1, points == 2, points == 1}});
+                if (batches[shard].size() == BATCH_SIZE)
+                    Flush(shard);
+
+                positions++;
+                return ++plies < options.plies;
+            });
+
+            illegal += !legal;
+        }
+
+        for (std::size_t shard = 0; shard < SHARDS; shard++)
+            if (!batches[shard].empty())
+                Flush(shard);
+
+        totals.games += games;
+        totals.skipped += skipped;
+        totals.illegal += illegal;
+        totals.positions += positions;
+    }
+
+    // Turns the totals of one shard into book entries. Weights follow Polyglot: two per win and
+    // one per draw, scaled down per position when they overflow.
+    bool WriteShard(Shard                     &shard,
+                    const std::string         &spill,
+                    const Options             &options,
+                    std::vector<std::uint8_t> &output) {
+        std::vector<Record> moves;
+        const auto          Emit = [&] {
+            std::uint64_t best = 0;
+            for (const auto &record : moves)
+                best = std::max<std::uint64_t>(best, 2 * record.counts.wins + record.counts.draws);
+
+            std::stable_sort(moves.begin(), moves.end(), [](const auto &a, const auto &b) {
+                return 2 * a.counts.wins + a.counts.draws > 2 * b.counts.wins + b.counts.draws;
+            });
+
+            for (const auto &record : moves) {
+                const std::uint64_t score  = 2 * record.counts.wins + record.counts.draws;
+                const auto          weight = best > 0xFFFF ? score * 0xFFFF / best : score;
+                if (!weight)
+                    continue;
+
+                Book::Entry entry;
+                entry.key    = record.key.key;
+                entry.move   = record.key.move;
+                entry.weight = static_cast<std::uint16_t>(weight);
+
+                output.resize(output.size() + Book::ENTRY_SIZE);
+                Book::WriteEntry(entry, output.data() + output.size() - Book::ENTRY_SIZE);
+            }
+
+            moves.clear();
+        };
+
+        const bool ok = shard.Drain(spill, [&](const Record &record) {
+            if (!moves.empty() && moves.back().key.key != record.key.key)
+                Emit();
+            if (record.counts.games >= options.minGames)
+                moves.push_back(record);
+        });
+
+        Emit();
+        return ok;
+    }
+
+    bool Build(const std::vector<std::string> &files, const Options &options) {
+        const auto         start = std::chrono::steady_clock::now();
+        const auto         spill = options.output + ".spill";
+        std::vector<Shard> shards(SHARDS);
+        Totals             totals;
+
+        for (const auto &path : files) {
+            xt::PgnReader file;
+            if (!file.Open(path)) {
+                fmt::print(stderr, "could not open '{}'\n", path);
+                return false;
+            }
+
+            // Ranges are handed out in order, each worker reading the games that start in its own
+            const auto        text  = file.GetText();
+            const std::size_t chunk = std::max<std::size_t>(
+                text.size() / (options.threads * 16) + 1, std::size_t{1} << 20);
+
+            std::atomic<std::size_t> next{0};
+            std::vector<std::thread> workers;
+            for (std::size_t i = 0; i < options.threads; i++) {
+                workers.emplace_back([&] {
+                    for (std::size_t begin; (begin = next.fetch_add(chunk)) < text.size();)
+                        Ingest(text,
+                               begin,
+                               std::min(begin + chunk, text.size()),
+                               options,
+                               shards,
+                               spill,
+                               totals);
+                });
+            }
+
+            for (auto &worker : workers)
+                worker.join();
+        }
+
+        const std::chrono::duration<double> read = std::chrono::steady_clock::now() - start;
+
+        std::size_t runs = 0;
+        for (const auto &shard : shards)
+            runs += shard.GetRuns();
+
+        std::vector<std::vector<std::uint8_t>> outputs(SHARDS);
+        std::atomic<std::size_t>               next{0};
+        std::atomic<bool>                      ok{true};
+        std::vector<std::thread>               workers;
+        for (std::size_t i = 0; i < options.threads; i++) {
+            workers.emplace_back([&] {
+                for (std::size_t shard; (shard = next.fetch_add(1)) < SHARDS;)
+                    if (!WriteShard(shards[shard],
+                                    fmt::format("{}.{}", spill, shard),
+                                    options,
+                                    outputs[shard]))
+                        ok = false;
+            });
+        }
+
+        for (auto &worker : workers)
+            worker.join();
+
+        std::FILE *file = std::fopen(options.output.c_str(), "wb");
+        if (!ok || !file) {
+            fmt::print(stderr, "could not write '{}'\n", options.output);
+            if (file)
+                std::fclose(file);
+            return false;
+        }
+
+        std::size_t entries = 0;
+        for (const auto &output : outputs) {
+            std::fwrite(output.data(), 1, output.size(), file);
+            entries += output.size() / Book::ENTRY_SIZE;
+        }
+
+        if (std::fclose(file) != 0) {
+            fmt::print(stderr, "could not write '{}'\n", options.output);
+            return false;
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        fmt::print("{} games ({} without a result, {} with an illegal move), {} positions in "
+                   "{:.2f}s, {:.0f} games/s, {} spilled runs\n",
+                   totals.games.load(),
+                   totals.skipped.load(),
+                   totals.illegal.load(),
+                   totals.positions.load(),
+                   read.count(),
+                   totals.games / std::max(read.count(), 1e-9),
+                   runs);
+        fmt::print("{}: {} entries, {:.2f}s total, peak RSS {} MB\n",
+                   options.output,
+                   entries,
+                   elapsed.count(),
+                   GetPeakRss());
+        return true;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    Options                  options;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "-p" && i + 1 < argc) {
+            options.plies = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-n" && i + 1 < argc) {
+            options.minGames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-m" && i + 1 < argc) {
+            options.memory = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-t" && i + 1 < argc) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (!arg.empty() && arg[0] != '-') {
+            files.push_back(arg);
+        } else {
+            files.clear();
+            break;
+        }
+    }
+
+    if (files.empty()) {
+        fmt::print(stderr,
+                   "usage: {} [-o book] [-p plies] [-n min games] [-m memory MB] [-t threads] "
+                   "pgn...\n",
+                   argv[0]);
+        return 1;
+    }
+
+    return Build(files, options) ? 0 : 1;
+}
\ No newline at end of file
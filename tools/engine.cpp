@@ -0,0 +1,462 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+#include "eval.hpp"
+#include "kpk.hpp"
+#include "nnue.hpp"
+#include "search.hpp"
+
+namespace {
+    constexpr const char *BENCH_FENS[] = {
+        xt::Board::START_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
+
+    struct Engine {
+        xt::Board                  board;
+        std::vector<std::uint64_t> history;
+        xt::Search                 search;
+        xt::Book                   book;
+        std::size_t                threads{1};
+        bool                       ownBook{true};
+    };
+
+    std::string FormatScore(int score) {
+        if (std::abs(score) < xt::SCORE_MATE_IN_MAX)
+            return fmt::format("cp {}", score);
+
+        const int moves = (xt::SCORE_MATE - std::abs(score) + 1) / 2;
+        return fmt::format("mate {}", score > 0 ? moves : -moves);
+    }
+
+    void PrintInfo(const xt::SearchInfo &info) {
+        std::string pv;
+        for (const auto &move : info.pv)
+            pv += " " + move.ToString();
+
+        const auto ms = std::max<std::int64_t>(info.time.count(), 1);
+        fmt::print("info depth {} multipv {} score {} nodes {} nps {} time {} hashfull {} tbhits {} "
+                   "pv{}\n",
+                   info.depth,
+                   info.line,
+                   FormatScore(info.score),
+                   info.nodes,
+                   info.nodes * 1000 / ms,
+                   info.time.count(),
+                   info.hashfull,
+                   info.stats.tablebaseHits,
+                   pv);
+        fmt::print("info string cutoffs {} first-move {:.1f}% null {} lmr {} futility {} rfp {} "
+                   "pvs-researches {} aspiration-researches {} pawn-hits {:.1f}% "
+                   "eval-hits {:.1f}%\n",
+                   info.stats.cutoffs,
+                   info.stats.GetFirstMoveCutoffRate(),
+                   info.stats.nullMoveCutoffs,
+                   info.stats.reductions,
+                   info.stats.futilityPrunes,
+                   info.stats.reverseFutilityPrunes,
+                   info.stats.pvsResearches,
+                   info.stats.aspirationResearches,
+                   info.stats.GetPawnHitRate(),
+                   info.stats.GetEvalHitRate());
+        std::fflush(stdout);
+    }
+
+    void PrintBestMove(const xt::Move &move, const xt::Move &ponder) {
+        if (ponder.IsValid())
+            fmt::print("bestmove {} ponder {}\n", move.ToString(), ponder.ToString());
+        else
+            fmt::print("bestmove {}\n", move.ToString());
+        std::fflush(stdout);
+    }
+
+    // Reads a whole option value as a number, reporting values that are not
+    template <typename T>
+    bool ParseNumber(const std::string &name, const std::string &value, T &number) {
+        const auto end    = value.data() + value.size();
+        const auto result = std::from_chars(value.data(), end, number);
+        if (result.ec == std::errc{} && result.ptr == end)
+            return true;
+
+        fmt::print("info string invalid value '{}' for option '{}'\n", value, name);
+        return false;
+    }
+
+    void SetOption(Engine &engine, std::istringstream &args) {
+        std::string token, name, value;
+        while (args >> token && token != "name") { }
+        while (args >> token && token != "value")
+            name += (name.empty() ? "" : " ") + token;
+        while (args >> token)
+            value += (value.empty() ? "" : " ") + token;
+
+        auto        options = engine.search.GetOptions();
+        std::size_t number  = 0;
+        if (name == "Threads") {
+            if (ParseNumber(name, value, number)) {
+                engine.threads = std::clamp<std::size_t>(number, 1, 256);
+                engine.search.SetThreads(engine.threads);
+            }
+        } else if (name == "Hash") {
+            if (ParseNumber(name, value, number))
+                engine.search.SetHashSize(std::clamp<std::size_t>(number, 1, 65536));
+        } else if (name == "EvalCache") {
+            if (ParseNumber(name, value, number))
+                engine.search.SetEvalCacheSize(std::clamp<std::size_t>(number, 0, 1048576));
+        } else if (name == "NullMovePruning") {
+            options.nullMove = value == "true";
+        } else if (name == "LateMoveReductions") {
+            options.lateMoveReductions = value == "true";
+        } else if (name == "FutilityPruning") {
+            options.futility = value == "true";
+        } else if (name == "ReverseFutilityPruning") {
+            options.reverseFutility = value == "true";
+        } else if (name == "MultiPV") {
+            if (ParseNumber(name, value, number))
+                options.multiPV = std::clamp<std::size_t>(number, 1, xt::MoveList::CAPACITY);
+        } else if (name == "EvalFile") {
+            // Searching threads evaluate through the active network, so they must be finished
+            // before it is replaced
+            engine.search.Stop();
+            engine.search.Wait();
+            if (value.empty() || value == "<empty>") {
+                xt::Network::SetActive(nullptr);
+            } else if (auto network = xt::Network::Load(value)) {
+                fmt::print("info string loaded network '{}' using {} kernels\n",
+                           value,
+                           xt::Network::GetName(network->GetIsa()));
+                xt::Network::SetActive(std::move(network));
+            } else {
+                fmt::print("info string failed to load network '{}'\n", value);
+            }
+
+            // Rebuild the position so it carries an accumulator for the new network, and forget
+            // scores cached from the old evaluation in the hash and eval cache
+            engine.board.LoadFen(engine.board.GetFen());
+            engine.search.Clear();
+        } else if (name == "TablebasePath") {
+            const auto path   = value == "<empty>" ? std::string{} : value;
+            const auto tables = engine.search.SetTablebasePath(path);
+            if (!path.empty())
+                fmt::print("info string found {} endgame tables in '{}'\n", tables, path);
+            if (const auto syzygy = path.empty() ? 0 : xt::Tablebase::CountSyzygyFiles(path))
+                fmt::print("info string skipped {} Syzygy files, only tables built by tbgen are "
+                           "supported\n",
+                           syzygy);
+        } else if (name == "TablebaseProbeDepth") {
+            if (int depth = 0; ParseNumber(name, value, depth))
+                options.tablebaseDepth = std::clamp(depth, 1, 100);
+        } else if (name == "TablebaseProbeLimit") {
+            if (ParseNumber(name, value, number))
+                options.tablebaseLimit =
+                    std::clamp<std::size_t>(number, 0, xt::EndgameTable::MAX_PIECES);
+        } else if (name == "OwnBook") {
+            engine.ownBook = value == "true";
+        } else if (name == "BookFile") {
+            engine.book.Close();
+            if (!value.empty() && value != "<empty>") {
+                if (engine.book.Open(value))
+                    fmt::print("info string opened book '{}' with {} entries\n",
+                               value,
+                               engine.book.GetSize());
+                else
+                    fmt::print("info string failed to open book '{}'\n", value);
+            }
+        } else if (name == "Ponder") {
+            // Only tells us the GUI may send 'go ponder', which is always supported
+        } else {
+            fmt::print("info string unknown option '{}'\n", name);
+        }
+
+        engine.search.SetOptions(options);
+    }
+
+    void Position(Engine &engine, std::istringstream &args) {
+        std::string token, fen;
+        args >> token;
+        if (token == "startpos") {
+            fen = xt::Board::START_FEN;
+            args >> token;
+        } else if (token == "fen") {
+            while (args >> token && token != "moves")
+                fen += token + " ";
+        }
+
+        if (!engine.board.LoadFen(fen)) {
+            fmt::print("info string invalid position '{}'\n", fen);
+            return;
+        }
+
+        engine.history.clear();
+        while (args >> token) {
+            const auto move = engine.board.ParseMove(token);
+            if (!move) {
+                fmt::print("info string illegal move '{}'\n", token);
+                break;
+            }
+
+            engine.history.push_back(engine.board.GetHash());
+            engine.board.MakeMove(*move);
+        }
+    }
+
+    std::chrono::milliseconds ReadMilliseconds(std::istringstream &args) {
+        std::int64_t ms = 0;
+        args >> ms;
+        return std::chrono::milliseconds(std::max<std::int64_t>(ms, 0));
+    }
+
+    void Go(Engine &engine, std::istringstream &args) {
+        xt::SearchLimits limits;
+
+        std::string token;
+        while (args >> token) {
+            if (token == "depth")
+                args >> limits.depth;
+            else if (token == "nodes")
+                args >> limits.nodes;
+            else if (token == "infinite")
+                limits.infinite = true;
+            else if (token == "ponder")
+                limits.ponder = true;
+            else if (token == "movestogo")
+                args >> limits.movestogo;
+            else if (token == "movetime")
+                limits.movetime = ReadMilliseconds(args);
+            else if (token == "wtime")
+                limits.time[xt::Team::WHITE] = ReadMilliseconds(args);
+            else if (token == "btime")
+                limits.time[xt::Team::BLACK] = ReadMilliseconds(args);
+            else if (token == "winc")
+                limits.increment[xt::Team::WHITE] = ReadMilliseconds(args);
+            else if (token == "binc")
+                limits.increment[xt::Team::BLACK] = ReadMilliseconds(args);
+        }
+
+        // Book moves are played straight away, except when the GUI expects us to keep thinking
+        if (engine.ownBook && !limits.ponder && !limits.infinite) {
+            if (const auto move = engine.book.Pick(engine.board)) {
+                PrintBestMove(*move, {});
+                return;
+            }
+        }
+
+        engine.search.Start(engine.board, engine.history, limits);
+    }
+
+    std::uint64_t Perft(const xt::Board &board, int depth) {
+        xt::MoveList moves;
+        board.GenerateMoves(moves);
+        if (depth <= 1)
+            return depth == 1 ? moves.Size() : 1;
+
+        std::uint64_t nodes = 0;
+        for (const auto &move : moves) {
+            xt::Board child{board};
+            child.MakeMove(move);
+            nodes += Perft(child, depth - 1);
+        }
+
+        return nodes;
+    }
+
+    // Time to a fixed depth over the bench positions for 1, 2, 4, ... up to the Threads setting
+    void Bench(Engine &engine, std::istringstream &args) {
+        int depth = 5;
+        args >> depth;
+
+        engine.search.SetInfoCallback(nullptr);
+        engine.search.SetBestMoveCallback(nullptr);
+
+        double baseline = 0.0;
+        for (std::size_t threads = 1;; threads = std::min(threads * 2, engine.threads)) {
+            engine.search.SetThreads(threads);
+
+            std::uint64_t   nodes   = 0;
+            auto            elapsed = std::chrono::steady_clock::duration::zero();
+            xt::SearchStats stats;
+            for (const auto *fen : BENCH_FENS) {
+                xt::Board board;
+                board.LoadFen(fen);
+
+                xt::SearchLimits limits;
+                limits.depth = depth;
+
+                engine.search.Clear();
+                const auto start = std::chrono::steady_clock::now();
+                engine.search.Start(board, {}, limits);
+                engine.search.Wait();
+                elapsed += std::chrono::steady_clock::now() - start;
+                nodes += engine.search.GetNodes();
+                stats += engine.search.GetStats();
+            }
+
+            const double seconds = std::chrono::duration<double>(elapsed).count();
+            if (threads == 1)
+                baseline = seconds;
+
+            fmt::print("threads {:>3} depth {} time {:>8.0f} ms nodes {:>10} nps {:>9.0f} "
+                       "speedup {:.2f} first-move cutoffs {:.1f}% pawn hits {:.1f}% "
+                       "eval hits {:.1f}%\n",
+                       threads,
+                       depth,
+                       seconds * 1000,
+                       nodes,
+                       nodes / std::max(seconds, 1e-9),
+                       baseline / std::max(seconds, 1e-9),
+                       stats.GetFirstMoveCutoffRate(),
+                       stats.GetPawnHitRate(),
+                       stats.GetEvalHitRate());
+
+            if (threads >= engine.threads)
+                break;
+        }
+
+        engine.search.SetThreads(engine.threads);
+        engine.search.SetInfoCallback(PrintInfo);
+        engine.search.SetBestMoveCallback(PrintBestMove);
+    }
+
+    // Static evaluations per second over the bench positions, for the hand written evaluation
+    // and for every network kernel the CPU supports. Without an EvalFile the network kernels are
+    // timed on random weights.
+    void EvalBench(std::istringstream &args) {
+        int count = 1000000;
+        args >> count;
+
+        std::vector<xt::Board> boards(std::size(BENCH_FENS));
+        for (std::size_t i = 0; i < boards.size(); i++)
+            boards[i].LoadFen(BENCH_FENS[i]);
+
+        const auto Time = [&](const char *name, auto &&evaluate) {
+            std::int64_t sink  = 0;
+            const auto   start = std::chrono::steady_clock::now();
+            for (int i = 0; i < count; i++)
+                sink += evaluate(i % boards.size());
+
+            const double seconds = std::chrono::duration<double>(
+                                       std::chrono::steady_clock::now() - start)
+                                       .count();
+            fmt::print("{:<10} {:>12.0f} evals/s (checksum {})\n",
+                       name,
+                       count / std::max(seconds, 1e-9),
+                       sink);
+        };
+
+        const auto                  *network = xt::Network::GetActive();
+        std::unique_ptr<xt::Network> random;
+        if (!network) {
+            xt::PawnTable pawns;
+            Time("classical", [&](std::size_t i) { return xt::Evaluate(boards[i], pawns); });
+
+            random  = xt::Network::CreateRandom(0xC0FFEE);
+            network = random.get();
+            fmt::print("info string no EvalFile loaded, timing the network on random weights\n");
+        }
+
+        std::vector<xt::Accumulator> accumulators(boards.size());
+        for (std::size_t i = 0; i < boards.size(); i++)
+            for (const auto team : {xt::Team::WHITE, xt::Team::BLACK})
+                network->Refresh(boards[i], team, accumulators[i]);
+
+        for (int isa = 0; isa < xt::Network::ISA_MAX; isa++) {
+            const auto path = static_cast<xt::Network::Isa>(isa);
+            if (!xt::Network::IsSupported(path))
+                continue;
+
+            Time(xt::Network::GetName(path), [&](std::size_t i) {
+                return network->Evaluate(accumulators[i], boards[i].GetTurn(), path);
+            });
+        }
+    }
+} // namespace
+
+int main() {
+    xt::Kpk::Initialize();
+
+    Engine engine;
+    engine.board.LoadFen(xt::Board::START_FEN);
+    engine.search.SetInfoCallback(PrintInfo);
+    engine.search.SetBestMoveCallback(PrintBestMove);
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream args(line);
+        std::string        command;
+        args >> command;
+
+        if (command == "uci") {
+            fmt::print("id name chess\n");
+            fmt::print("option name Threads type spin default 1 min 1 max 256\n");
+            fmt::print("option name Hash type spin default 16 min 1 max 65536\n");
+            fmt::print("option name EvalCache type spin default {} min 0 max 1048576\n",
+                       xt::EvalCache::DEFAULT_SIZE);
+            fmt::print("option name NullMovePruning type check default true\n");
+            fmt::print("option name LateMoveReductions type check default true\n");
+            fmt::print("option name FutilityPruning type check default true\n");
+            fmt::print("option name ReverseFutilityPruning type check default true\n");
+            fmt::print("option name Ponder type check default false\n");
+            fmt::print("option name OwnBook type check default true\n");
+            fmt::print("option name BookFile type string default <empty>\n");
+            fmt::print("option name MultiPV type spin default 1 min 1 max 256\n");
+            fmt::print("option name EvalFile type string default <empty>\n");
+            fmt::print("option name TablebasePath type string default <empty>\n");
+            fmt::print("option name TablebaseProbeDepth type spin default 1 min 1 max 100\n");
+            fmt::print("option name TablebaseProbeLimit type spin default {} min 0 max {}\n",
+                       xt::EndgameTable::MAX_PIECES,
+                       xt::EndgameTable::MAX_PIECES);
+            fmt::print("uciok\n");
+        } else if (command == "isready") {
+            fmt::print("readyok\n");
+        } else if (command == "setoption") {
+            SetOption(engine, args);
+        } else if (command == "ucinewgame") {
+            engine.search.Stop();
+            engine.search.Clear();
+        } else if (command == "position") {
+            Position(engine, args);
+        } else if (command == "go") {
+            Go(engine, args);
+        } else if (command == "stop") {
+            engine.search.Stop();
+        } else if (command == "ponderhit") {
+            engine.search.PonderHit();
+        } else if (command == "quit") {
+            break;
+        } else if (command == "bench") {
+            Bench(engine, args);
+        } else if (command == "evalbench") {
+            EvalBench(args);
+        } else if (command == "perft") {
+            int depth = 1;
+            args >> depth;
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto nodes = Perft(engine.board, depth);
+            const auto ms    = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+            fmt::print("nodes {} time {} ms\n", nodes, ms.count());
+        } else if (command == "d") {
+            fmt::print("{}\n", engine.board.GetFen());
+        } else if (!command.empty()) {
+            fmt::print("info string unknown command '{}'\n", command);
+        }
+
+        std::fflush(stdout);
+    }
+
+    engine.search.Stop();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "board.hpp"
+#include "search.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::size_t      threads = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t      hash    = 16;
+        xt::SearchLimits limits;
+        bool             verbose = false;
+    };
+
+    // A test position with the moves that solve it (bm) or that must be avoided (am)
+    struct Position {
+        std::string           id;
+        xt::Board             board;
+        std::vector<xt::Move> best;
+        std::vector<xt::Move> avoid;
+    };
+
+    struct Result {
+        xt::Move                  move;
+        bool                      solved{false};
+        std::chrono::milliseconds time{0}; // when the search settled on a solution
+        std::uint64_t             nodes{0};
+        std::uint64_t             solvedNodes{0};
+    };
+
+    std::string_view Trim(std::string_view text) {
+        const auto begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string_view::npos)
+            return {};
+
+        return text.substr(begin, text.find_last_not_of(" \t\r\n") - begin + 1);
+    }
+
+    // Reads the four FEN fields and the bm, am and id opcodes of an EPD line
+    bool ParseEpd(std::string_view line, Position &position) {
+        std::string fen;
+        std::size_t pos = 0;
+        for (int i = 0; i < 4; i++) {
+            const auto begin = line.find_first_not_of(" \t", pos);
+            if (begin == std::string_view::npos)
+                return false;
+
+            pos = std::min(line.find_first_of(" \t", begin), line.size());
+            fen += (i ? " " : "");
+            fen += line.substr(begin, pos - begin);
+        }
+
+        if (!position.board.LoadFen(fen))
+            return false;
+
+        for (auto rest = line.substr(pos); !Trim(rest).empty();) {
+            // Operands may be quoted, and a quoted string may hold a ';'
+            std::size_t end = 0;
+            for (bool quoted = false; end < rest.size() && (quoted || rest[end] != ';'); end++)
+                if (rest[end] == '"')
+                    quoted = !quoted;
+
+            const auto operation = Trim(rest.substr(0, end));
+            rest                 = rest.substr(std::min(end + 1, rest.size()));
+
+            const auto space    = std::min(operation.find(' '), operation.size());
+            const auto opcode   = operation.substr(0, space);
+            auto       operands = Trim(operation.substr(space));
+            if (opcode == "id") {
+                if (operands.size() >= 2 && operands.front() == '"' && operands.back() == '"')
+                    operands = operands.substr(1, operands.size() - 2);
+                position.id = operands;
+                continue;
+            }
+
+            if (opcode != "bm" && opcode != "am")
+                continue;
+
+            auto              &moves = opcode == "bm" ? position.best : position.avoid;
+            std::istringstream stream{std::string{operands}};
+            for (std::string text; stream >> text;) {
+                auto move = position.board.ParseSan(text);
+                if (!move)
+                    move = position.board.ParseMove(text);
+                if (!move)
+                    return false;
+                moves.push_back(*move);
+            }
+        }
+
+        return !position.best.empty() || !position.avoid.empty();
+    }
+
+    bool IsSolution(const Position &position, const xt::Move &move) {
+        if (!position.best.empty() &&
+            std::find(position.best.begin(), position.best.end(), move) == position.best.end())
+            return false;
+
+        return std::find(position.avoid.begin(), position.avoid.end(), move) ==
+               position.avoid.end();
+    }
+
+    // Searches the position, noting when the best move last changed to a solution
+    Result Solve(const Options &options, const Position &position, xt::Search &search) {
+        Result result;
+        bool   solving = false;
+        search.SetInfoCallback([&](const xt::SearchInfo &info) {
+            if (info.line != 1 || info.pv.empty())
+                return;
+
+            const bool solves = IsSolution(position, info.pv[0]);
+            if (solves && !solving) {
+                result.time        = info.time;
+                result.solvedNodes = info.nodes;
+            }
+
+            solving = solves;
+        });
+
+        const auto start = Clock::now();
+        search.Clear();
+        search.Start(position.board, {}, options.limits);
+        search.Wait();
+        search.SetInfoCallback(nullptr);
+
+        result.move   = search.GetBestMove();
+        result.nodes  = search.GetNodes();
+        result.solved = IsSolution(position, result.move);
+
+        // The move of an iteration cut short never made it into an info line
+        if (result.solved && !solving) {
+            const auto elapsed = Clock::now() - start;
+            result.time        = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+            result.solvedNodes = result.nodes;
+        }
+
+        return result;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    Options                  options;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-n" && i + 1 < argc) {
+            options.limits.nodes = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-m" && i + 1 < argc) {
+            options.limits.movetime = std::chrono::milliseconds(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "-d" && i + 1 < argc) {
+            options.limits.depth = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-H" && i + 1 < argc) {
+            options.hash = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else if (!arg.empty() && arg[0] != '-') {
+            files.push_back(arg);
+        } else {
+            files.clear();
+            break;
+        }
+    }
+
+    const auto &limits = options.limits;
+    if (files.empty() || (!limits.nodes && !limits.movetime.count() && !limits.depth)) {
+        fmt::print(stderr,
+                   "usage: {} (-n nodes | -m movetime ms | -d depth) [-t threads] [-H hash MB] "
+                   "[-v] epd...\n",
+                   argv[0]);
+        return 1;
+    }
+
+    std::vector<Position> positions;
+    for (const auto &path : files) {
+        std::ifstream file{path};
+        if (!file) {
+            fmt::print(stderr, "could not open '{}'\n", path);
+            return 1;
+        }
+
+        std::size_t number = 0;
+        for (std::string line; std::getline(file, line);) {
+            number++;
+            if (Trim(line).empty() || line[0] == '#')
+                continue;
+
+            Position position;
+            if (!ParseEpd(line, position)) {
+                fmt::print(stderr, "{}:{}: bad EPD line\n", path, number);
+                continue;
+            }
+
+            if (position.id.empty())
+                position.id = fmt::format("{}:{}", path, number);
+            positions.push_back(std::move(position));
+        }
+    }
+
+    // Each thread takes the next position with a single-threaded search of its own
+    std::vector<Result>      results(positions.size());
+    std::atomic<std::size_t> next{0};
+    std::mutex               mutex;
+    const auto               start   = Clock::now();
+    const auto               threads = std::min(options.threads, positions.size());
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < threads; i++) {
+        workers.emplace_back([&] {
+            xt::Search search;
+            search.SetHashSize(options.hash);
+            for (std::size_t index; (index = next++) < positions.size();) {
+                results[index] = Solve(options, positions[index], search);
+                if (!options.verbose)
+                    continue;
+
+                const auto     &position = positions[index];
+                const auto     &result   = results[index];
+                std::lock_guard lock{mutex};
+                fmt::print("{:<24} {:<8} {} {:>8} ms {:>10} nodes\n",
+                           position.id,
+                           position.board.GetSan(result.move),
+                           result.solved ? "solved" : "failed",
+                           result.time.count(),
+                           result.solvedNodes);
+            }
+        });
+    }
+
+    for (auto &worker : workers)
+        worker.join();
+
+    const double  seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::size_t   solved  = 0;
+    double        time    = 0.0;
+    std::uint64_t nodes = 0, solvedNodes = 0;
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        nodes += results[i].nodes;
+        if (!results[i].solved)
+            continue;
+
+        solved++;
+        time += results[i].time.count() / 1000.0;
+        solvedNodes += results[i].solvedNodes;
+    }
+
+    if (!options.verbose) {
+        for (std::size_t i = 0; i < positions.size(); i++)
+            if (!results[i].solved)
+                fmt::print("failed {}: played {}\n",
+                           positions[i].id,
+                           positions[i].board.GetSan(results[i].move));
+    }
+
+    // Every search runs on one thread, so the CPU time is the wall time over the cores in use
+    const auto   hardware = std::max(1u, std::thread::hardware_concurrency());
+    const double cpu      = seconds * std::clamp<std::size_t>(threads, 1, hardware);
+    fmt::print("solved {} of {} ({:.1f}%) in {:.1f}s on {} threads, {:.2f} solved per CPU-second\n",
+               solved,
+               positions.size(),
+               100.0 * solved / std::max<std::size_t>(positions.size(), 1),
+               seconds,
+               threads,
+               solved / std::max(cpu, 1e-9));
+    fmt::print("time to solution {:.3f}s and {:.0f} nodes on average, {} nodes searched ({:.0f} "
+               "nps per core)\n",
+               time / std::max<std::size_t>(solved, 1),
+               static_cast<double>(solvedNodes) / std::max<std::size_t>(solved, 1),
+               nodes,
+               nodes / std::max(cpu, 1e-9));
+    return 0;
+}
\ No newline at end of file
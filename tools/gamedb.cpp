@@ -0,0 +1,112 @@
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "gamedb.hpp"
+#include "pgn.hpp"
+#include "posindex.hpp"
+
+namespace {
+    // Lists the games of database reaching the position, looked up in index
+    int FindPosition(const xt::GameDatabase &database, const char *path, const char *fen) {
+        xt::PositionIndex index;
+        if (!index.Open(path)) {
+            fmt::print(stderr, "could not open '{}'\n", path);
+            return 1;
+        }
+
+        xt::Board board;
+        if (!board.LoadFen(fen)) {
+            fmt::print(stderr, "bad FEN '{}'\n", fen);
+            return 1;
+        }
+
+        std::vector<xt::PositionIndex::Posting> postings;
+        const auto                              start = std::chrono::steady_clock::now();
+        index.Find(board.GetHash(), postings);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        for (const auto &[game, ply] : postings) {
+            if (game >= database.GetSize())
+                continue;
+
+            fmt::print("{} ply {}: {} - {} {}\n",
+                       game,
+                       ply,
+                       database.GetTag(game, xt::GameDatabase::WHITE),
+                       database.GetTag(game, xt::GameDatabase::BLACK),
+                       xt::GameDatabase::GetResultText(database.GetResult(game)));
+        }
+
+        fmt::print("{} games in {:.3f}ms\n",
+                   postings.size(),
+                   std::chrono::duration<double, std::milli>(elapsed).count());
+        return 0;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fmt::print(stderr, "usage: {} database [game... | -i index fen]\n", argv[0]);
+        return 1;
+    }
+
+    xt::GameDatabase database;
+    if (!database.Open(argv[1])) {
+        fmt::print(stderr, "could not open '{}'\n", argv[1]);
+        return 1;
+    }
+
+    if (argc == 5 && std::string{argv[2]} == "-i")
+        return FindPosition(database, argv[3], argv[4]);
+
+    if (argc == 2) {
+        std::size_t plies = 0;
+        for (std::size_t game = 0; game < database.GetSize(); game++)
+            plies += database.GetPlies(game);
+
+        fmt::print("{} games, {} plies\n", database.GetSize(), plies);
+        return 0;
+    }
+
+    // Games are numbered from 0 in the order they were added
+    xt::Board        board;
+    xt::GameRecorder recorder;
+    std::string      pgn;
+    for (int i = 2; i < argc; i++) {
+        char      *end;
+        const auto game = std::strtoull(argv[i], &end, 10);
+        if (*end || game >= database.GetSize()) {
+            fmt::print(stderr, "no game '{}'\n", argv[i]);
+            return 1;
+        }
+
+        if (!database.Setup(game, board)) {
+            fmt::print(stderr, "game {} has a bad FEN\n", game);
+            continue;
+        }
+
+        recorder.Reset(board);
+        database.Replay(game, board, [&](const xt::Board &position, const xt::Move &move) {
+            recorder.Add(position, move);
+            return true;
+        });
+
+        for (int tag = 0; tag < xt::GameDatabase::FEN; tag++) {
+            const auto name = static_cast<xt::GameDatabase::Tag>(tag);
+            recorder.SetTag(xt::GameDatabase::GetTagName(name), database.GetTag(game, name));
+        }
+
+        recorder.SetResult(xt::GameDatabase::GetResultText(database.GetResult(game)));
+
+        pgn.clear();
+        recorder.Write(pgn);
+        fmt::print("{}", pgn);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.hpp"
+#include "gamedb.hpp"
+#include "pgn.hpp"
+#include "pipeline.hpp"
+#include "posindex.hpp"
+
+namespace {
+    struct Options {
+        std::string output;
+        std::string database;
+        std::string index;
+        std::size_t memory    = 256;
+        std::size_t threads   = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t batchSize = 1 << 20;
+        std::size_t queueSize = 16;
+    };
+
+    // A game bound for the database, its tags still escaped and its moves in Batch::moves
+    struct Game {
+        xt::GameDatabase::Tags   tags;
+        xt::GameDatabase::Result result;
+        std::size_t              plies;
+    };
+
+    // A position reached by the game at Batch::database[game]
+    struct Position {
+        std::uint64_t key;
+        std::uint32_t game;
+        std::uint32_t ply;
+    };
+
+    // What the workers make of one batch of games
+    struct Batch {
+        std::size_t                games{0};
+        std::size_t                illegal{0};
+        std::size_t                plies{0};
+        std::string                pgn;
+        std::vector<Game>          database;
+        std::vector<std::uint16_t> moves;
+        std::vector<Position>      positions;
+    };
+
+    // Tag values are read as written, with their escapes
+    std::string Unescape(std::string_view value) {
+        std::string result;
+        for (std::size_t i = 0; i < value.size(); i++) {
+            if (value[i] == '\\' && i + 1 < value.size())
+                i++;
+            result += value[i];
+        }
+
+        return result;
+    }
+
+    Batch Replay(std::string_view text, bool write, bool store, bool index) {
+        Batch            batch;
+        xt::PgnReader    reader{text};
+        xt::PgnGame      game;
+        xt::Board        board;
+        xt::GameRecorder recorder;
+        while (reader.Next(game)) {
+            batch.games++;
+            if (!game.Setup(board)) {
+                batch.illegal++;
+                continue;
+            }
+
+            recorder.Reset(board);
+            const auto    moves     = batch.moves.size();
+            const auto    positions = batch.positions.size();
+            const auto    id        = static_cast<std::uint32_t>(batch.database.size());
+            std::uint32_t ply       = 0;
+            const auto    Record    = [&](const xt::Board &position, const xt::Move &move) {
+                if (write)
+                    recorder.Add(position, move);
+                if (store)
+                    batch.moves.push_back(move.Pack());
+                if (index)
+                    batch.positions.push_back({position.GetHash(), id, ply});
+                ply++;
+                return true;
+            };
+
+            if (!game.Replay(board, Record)) {
+                batch.moves.resize(moves);
+                batch.positions.resize(positions);
+                batch.illegal++;
+                continue;
+            }
+
+            // Only games that replay to the end count towards the totals
+            batch.plies += ply;
+
+            // The position the game ends in
+            if (index)
+                batch.positions.push_back({board.GetHash(), id, ply});
+
+            if (store) {
+                auto &entry = batch.database.emplace_back();
+                for (int i = 0; i < xt::GameDatabase::TAGS; i++) {
+                    const auto tag  = static_cast<xt::GameDatabase::Tag>(i);
+                    entry.tags[tag] = game.GetTag(xt::GameDatabase::GetTagName(tag));
+                }
+
+                entry.result = xt::GameDatabase::ParseResult(game.GetResult());
+                entry.plies  = ply;
+            }
+
+            if (!write)
+                continue;
+
+            for (std::size_t i = 0; i < game.GetTagCount(); i++) {
+                const auto &tag = game.GetTag(i);
+                if (tag.name != "SetUp" && tag.name != "FEN")
+                    recorder.SetTag(tag.name, Unescape(tag.value));
+            }
+
+            recorder.SetResult(game.GetResult().empty() ? "*" : game.GetResult());
+            recorder.Write(batch.pgn);
+        }
+
+        return batch;
+    }
+
+    void PrintStage(const char *name, const xt::StageStats &stage, double seconds) {
+        fmt::print("{:<8} {:>8} batches {:>10.1f} MB {:>8.1f} MB/s  busy {:>7.2f}s  "
+                   "waiting {:>7.2f}s\n",
+                   name,
+                   stage.items,
+                   stage.bytes / 1e6,
+                   stage.bytes / 1e6 / std::max(seconds, 1e-9),
+                   std::chrono::duration<double>(stage.busy).count(),
+                   std::chrono::duration<double>(stage.waiting).count());
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    Options                  options;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "-d" && i + 1 < argc) {
+            options.database = argv[++i];
+        } else if (arg == "-i" && i + 1 < argc) {
+            options.index = argv[++i];
+        } else if (arg == "-m" && i + 1 < argc) {
+            options.memory = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-t" && i + 1 < argc) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-b" && i + 1 < argc) {
+            options.batchSize = std::max(1, std::atoi(argv[++i])) * std::size_t{1024};
+        } else if (arg == "-q" && i + 1 < argc) {
+            options.queueSize = std::max(1, std::atoi(argv[++i]));
+        } else if (!arg.empty() && arg[0] != '-') {
+            files.push_back(arg);
+        } else {
+            files.clear();
+            break;
+        }
+    }
+
+    // Positions are indexed by game number, so an index comes with a database
+    if (files.empty() || (!options.index.empty() && options.database.empty())) {
+        fmt::print(stderr,
+                   "usage: {} [-o pgn] [-d database [-i index] [-m memory MB]] [-t threads] "
+                   "[-b batch KB] [-q queue size] pgn...\n",
+                   argv[0]);
+        return 1;
+    }
+
+    std::FILE *output = nullptr;
+    if (!options.output.empty() && !(output = std::fopen(options.output.c_str(), "wb"))) {
+        fmt::print(stderr, "could not create '{}'\n", options.output);
+        return 1;
+    }
+
+    xt::GameDatabaseWriter database;
+    if (!options.database.empty() && !database.Open(options.database)) {
+        fmt::print(stderr, "could not create '{}'\n", options.database);
+        return 1;
+    }
+
+    xt::PositionIndexWriter index{options.memory << 20};
+    if (!options.index.empty() && !index.Open(options.index)) {
+        fmt::print(stderr, "could not create '{}'\n", options.index);
+        return 1;
+    }
+
+    const bool                   store   = !options.database.empty();
+    const bool                   indexed = !options.index.empty();
+    const xt::PgnPipeline<Batch> pipeline{options.threads, options.batchSize, options.queueSize};
+    for (const auto &path : files) {
+        xt::PgnReader file;
+        if (!file.Open(path)) {
+            fmt::print(stderr, "could not open '{}'\n", path);
+            return 1;
+        }
+
+        Batch      totals;
+        const auto stats = pipeline.Run(
+            file.GetText(),
+            [&](std::string_view text) {
+                return Replay(text, output != nullptr, store, indexed);
+            },
+            [&](Batch &&batch) {
+                totals.games += batch.games;
+                totals.illegal += batch.illegal;
+                totals.plies += batch.plies;
+                if (output)
+                    std::fwrite(batch.pgn.data(), 1, batch.pgn.size(), output);
+
+                // Tags are unescaped here, so the workers' batches stay views into the file
+                std::string          values[xt::GameDatabase::TAGS];
+                const std::uint16_t *moves = batch.moves.data();
+                const std::size_t    first = database.GetSize();
+                for (const auto &game : batch.database) {
+                    auto tags = game.tags;
+                    for (int tag = 0; tag < xt::GameDatabase::TAGS; tag++) {
+                        if (tags[tag].find('\\') != std::string_view::npos) {
+                            values[tag] = Unescape(tags[tag]);
+                            tags[tag]   = values[tag];
+                        }
+                    }
+
+                    database.Add(tags, game.result, moves, game.plies);
+                    moves += game.plies;
+                }
+
+                for (const auto &position : batch.positions)
+                    index.Add(position.key, first + position.game, position.ply);
+            });
+
+        const double seconds = std::chrono::duration<double>(stats.elapsed).count();
+        fmt::print("{}: {} games ({} illegal), {} plies in {:.2f}s, {:.0f} games/s on {} "
+                   "threads\n",
+                   path,
+                   totals.games,
+                   totals.illegal,
+                   totals.plies,
+                   seconds,
+                   totals.games / std::max(seconds, 1e-9),
+                   options.threads);
+        PrintStage("reader", stats.reader, seconds);
+        PrintStage("workers", stats.workers, seconds);
+        PrintStage("sink", stats.sink, seconds);
+    }
+
+    if (output && std::fclose(output) != 0) {
+        fmt::print(stderr, "could not write '{}'\n", options.output);
+        return 1;
+    }
+
+    if (store && !database.Close()) {
+        fmt::print(stderr, "could not write '{}'\n", options.database);
+        return 1;
+    }
+
+    if (indexed && !index.Close()) {
+        fmt::print(stderr, "could not write '{}'\n", options.index);
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
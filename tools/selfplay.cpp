@@ -0,0 +1,573 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "board.hpp"
+#include "pgn.hpp"
+#include "search.hpp"
+
+namespace {
+    using xt::Board;
+    using xt::Team;
+
+    // One side of the match. Both run the same engine, and differ only in these settings.
+    struct Player {
+        const char       *name;
+        xt::SearchOptions options;
+        std::size_t       hash{0}; // 0 for the -H setting
+    };
+
+    struct Options {
+        std::size_t      games       = 0; // 0 for 100, or no limit under an SPRT
+        std::size_t      concurrency = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t      hash        = 16;
+        int              maxPlies    = 400;
+        int              randomPlies = -1; // -1 for 8 without openings, or none with them
+        std::uint64_t    seed        = std::random_device{}();
+        xt::SearchLimits limits;
+        Player           players[2]{{"A", {}, 0}, {"B", {}, 0}};
+        std::string      openings;
+        std::string      output;
+        bool             verbose = false;
+
+        // Sequential probability ratio test of A against B
+        bool   sprt  = false;
+        double elo0  = 0.0;
+        double elo1  = 5.0;
+        double alpha = 0.05;
+        double beta  = 0.05;
+    };
+
+    // A starting position, and the moves played from it before the engines take over
+    struct Opening {
+        Board                 board;
+        std::vector<xt::Move> moves;
+    };
+
+    enum Termination {
+        CHECKMATE,
+        STALEMATE,
+        REPETITION,
+        FIFTY_MOVES,
+        MATERIAL,
+        MAX_PLIES,
+        ILLEGAL_MOVE,
+        NONE
+    };
+
+    constexpr const char *TERMINATIONS[] = {"checkmate",
+                                            "stalemate",
+                                            "repetition",
+                                            "fifty moves",
+                                            "material",
+                                            "max plies",
+                                            "illegal move"};
+
+    struct Game {
+        std::string   result;
+        Termination   termination{NONE};
+        int           plies{0};
+        std::uint64_t nodes{0};
+    };
+
+    // Results of game pairs, each opening played once with either player as white, counted by
+    // A's score over the pair in half points. Pairs cancel out most of the bias of an opening,
+    // so their scores vary less than those of single games and a test needs fewer of them.
+    struct Pentanomial {
+        std::size_t counts[5]{};
+
+    public:
+        std::size_t GetPairs() const {
+            std::size_t pairs = 0;
+            for (const auto count : counts)
+                pairs += count;
+            return pairs;
+        }
+
+        // Mean and variance of A's score per game over the pairs, between 0 and 1
+        void GetMoments(double &mean, double &variance) const {
+            const double pairs = std::max<double>(GetPairs(), 1);
+
+            mean = variance = 0.0;
+            for (int i = 0; i < 5; i++)
+                mean += i / 4.0 * counts[i] / pairs;
+            for (int i = 0; i < 5; i++)
+                variance += (i / 4.0 - mean) * (i / 4.0 - mean) * counts[i] / pairs;
+        }
+
+        // Log likelihood ratio of A being elo1 rather than elo0 stronger than B, using the
+        // normal approximation to the distribution of the pair scores. It stays at 0 until two
+        // different pair scores have been seen and there is a variance to go by.
+        double GetLlr(double elo0, double elo1) const {
+            double mean, variance;
+            GetMoments(mean, variance);
+            if (variance <= 0.0)
+                return 0.0;
+
+            const double s0 = GetScore(elo0), s1 = GetScore(elo1);
+            return GetPairs() * (s1 - s0) * (2 * mean - s0 - s1) / (2 * variance);
+        }
+
+        static double GetScore(double elo) {
+            return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+        }
+
+        static double GetElo(double score) {
+            score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+            return -400.0 * std::log10(1.0 / score - 1.0);
+        }
+    };
+
+    // Reads a 'Name=value' setting, named as the engine's UCI options are
+    bool SetPlayerOption(Player &player, std::string_view setting) {
+        const auto equals = setting.find('=');
+        if (equals == std::string_view::npos)
+            return false;
+
+        const auto name  = setting.substr(0, equals);
+        const auto value = setting.substr(equals + 1);
+        if (name == "Hash")
+            player.hash = std::max(1, std::atoi(std::string{value}.c_str()));
+        else if (name == "NullMovePruning")
+            player.options.nullMove = value == "true";
+        else if (name == "LateMoveReductions")
+            player.options.lateMoveReductions = value == "true";
+        else if (name == "FutilityPruning")
+            player.options.futility = value == "true";
+        else if (name == "ReverseFutilityPruning")
+            player.options.reverseFutility = value == "true";
+        else
+            return false;
+        return true;
+    }
+
+    // Reads one FEN or EPD per line, or the main lines of the games of a PGN file
+    bool LoadOpenings(const std::string &path, std::vector<Opening> &openings) {
+        if (path.size() > 4 && path.compare(path.size() - 4, 4, ".pgn") == 0) {
+            xt::PgnReader reader;
+            if (!reader.Open(path))
+                return false;
+
+            for (xt::PgnGame game; reader.Next(game);) {
+                Opening opening;
+                if (!game.Setup(opening.board))
+                    continue;
+
+                const auto start = opening.board;
+                const auto Add   = [&](const Board &, const xt::Move &move) {
+                    opening.moves.push_back(move);
+                    return true;
+                };
+
+                if (!game.Replay(opening.board, Add))
+                    continue;
+
+                opening.board = start;
+                openings.push_back(std::move(opening));
+            }
+
+            return true;
+        }
+
+        std::ifstream file{path};
+        if (!file)
+            return false;
+
+        // EPD has no move counters, and opcodes where they would be
+        for (std::string line; std::getline(file, line);) {
+            std::istringstream stream{line};
+            std::string        fen, field;
+            for (int i = 0; i < 6 && stream >> field; i++) {
+                if (i >= 4 && field.find_first_not_of("0123456789") != std::string::npos)
+                    break;
+                fen += (i ? " " : "") + field;
+            }
+
+            if (Opening opening; !fen.empty() && opening.board.LoadFen(fen))
+                openings.push_back(std::move(opening));
+        }
+
+        return true;
+    }
+
+    // Extends the opening by random legal moves, so that games starting from the same position
+    // still differ. Both games of a pair are given the same line.
+    Opening AddRandomPlies(Opening opening, int plies, std::mt19937_64 &random) {
+        Board board = opening.board;
+        for (const auto &move : opening.moves)
+            board.MakeMove(move);
+
+        for (int i = 0; i < plies; i++) {
+            xt::MoveList moves;
+            board.GenerateMoves(moves);
+            if (moves.Empty())
+                break;
+
+            const auto &move = moves[random() % moves.Size()];
+            opening.moves.push_back(move);
+            board.MakeMove(move);
+        }
+
+        return opening;
+    }
+
+    bool IsInsufficientMaterial(const Board &board) {
+        if (board.GetPieceCount() > 3)
+            return false;
+
+        for (xt::Int y = 0; y < Board::SIZE; y++) {
+            for (xt::Int x = 0; x < Board::SIZE; x++) {
+                const auto type = board[{x, y}].type;
+                if (type == xt::Piece::PAWN || type == xt::Piece::ROOK || type == xt::Piece::QUEEN)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Why the game is over in board, if it is. history holds the positions before it.
+    Termination GetTermination(const Board &board, const std::vector<std::uint64_t> &history) {
+        xt::MoveList moves;
+        board.GenerateMoves(moves);
+        if (moves.Empty())
+            return board.InCheck() ? CHECKMATE : STALEMATE;
+        if (board.GetHalfMoves() >= 100)
+            return FIFTY_MOVES;
+        if (IsInsufficientMaterial(board))
+            return MATERIAL;
+
+        // Repetitions can only go back as far as the last capture or pawn move
+        const auto since = std::min<std::size_t>(board.GetHalfMoves(), history.size());
+        const auto count = std::count(history.end() - since, history.end(), board.GetHash());
+        return count >= 2 ? REPETITION : NONE;
+    }
+
+    // Plays one game between two searches, recording it in recorder
+    Game Play(const Options    &options,
+              const Opening    &opening,
+              xt::Search       &white,
+              xt::Search       &black,
+              xt::GameRecorder &recorder) {
+        Board                      board = opening.board;
+        std::vector<std::uint64_t> history;
+        recorder.Reset(board);
+        for (const auto &move : opening.moves) {
+            history.push_back(board.GetHash());
+            recorder.Play(board, move);
+        }
+
+        white.Clear();
+        black.Clear();
+
+        Game game;
+        while ((game.termination = GetTermination(board, history)) == NONE) {
+            if (game.plies >= options.maxPlies) {
+                game.termination = MAX_PLIES;
+                break;
+            }
+
+            auto &search = board.GetTurn() == Team::WHITE ? white : black;
+            search.Start(board, history, options.limits);
+            search.Wait();
+            game.nodes += search.GetNodes();
+
+            // A search that returns no legal move forfeits rather than corrupting the game
+            const auto   move = search.GetBestMove();
+            xt::MoveList moves;
+            board.GenerateMoves(moves);
+            if (std::find(moves.begin(), moves.end(), move) == moves.end()) {
+                game.termination = ILLEGAL_MOVE;
+                break;
+            }
+
+            history.push_back(board.GetHash());
+            recorder.Play(board, move);
+            game.plies++;
+        }
+
+        if (game.termination == CHECKMATE || game.termination == ILLEGAL_MOVE)
+            game.result = board.GetTurn() == Team::WHITE ? "0-1" : "1-0";
+        else
+            game.result = "1/2-1/2";
+        return game;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    bool    valid = true;
+    for (int i = 1; i < argc && valid; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-g" && i + 1 < argc) {
+            options.games = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-c" && i + 1 < argc) {
+            options.concurrency = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-n" && i + 1 < argc) {
+            options.limits.nodes = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-m" && i + 1 < argc) {
+            options.limits.movetime = std::chrono::milliseconds(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "-d" && i + 1 < argc) {
+            options.limits.depth = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-H" && i + 1 < argc) {
+            options.hash = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-l" && i + 1 < argc) {
+            options.maxPlies = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "-e" && i + 1 < argc) {
+            options.openings = argv[++i];
+        } else if (arg == "-p" && i + 1 < argc) {
+            options.randomPlies = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "-r" && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-o" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if ((arg == "-A" || arg == "-B") && i + 1 < argc) {
+            valid = SetPlayerOption(options.players[arg == "-B"], argv[++i]);
+        } else if (arg == "-s" && i + 2 < argc) {
+            options.sprt = true;
+            options.elo0 = std::atof(argv[++i]);
+            options.elo1 = std::atof(argv[++i]);
+            valid        = options.elo0 < options.elo1;
+        } else if (arg == "-a" && i + 1 < argc) {
+            options.alpha = std::atof(argv[++i]);
+            valid         = options.alpha > 0.0 && options.alpha < 0.5;
+        } else if (arg == "-b" && i + 1 < argc) {
+            options.beta = std::atof(argv[++i]);
+            valid        = options.beta > 0.0 && options.beta < 0.5;
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else {
+            valid = false;
+        }
+    }
+
+    const auto &limits = options.limits;
+    if (!valid || (!limits.nodes && !limits.movetime.count() && !limits.depth)) {
+        fmt::print(stderr,
+                   "usage: {} (-n nodes | -m movetime ms | -d depth) [-g games] [-c concurrency] "
+                   "[-H hash MB] [-l max plies] [-e openings] [-p random plies] [-r seed] [-o pgn] "
+                   "[-A|-B Option=value] [-s elo0 elo1 [-a alpha] [-b beta]] [-v]\n",
+                   argv[0]);
+        return 1;
+    }
+
+    // Random lines from the starting position are too unbalanced and too alike to measure a
+    // small difference with
+    if (options.sprt && options.openings.empty()) {
+        fmt::print(stderr, "an SPRT needs an opening file (-e)\n");
+        return 1;
+    }
+
+    if (!options.games)
+        options.games = options.sprt ? std::numeric_limits<std::size_t>::max() : 100;
+
+    // Without openings every game would start from the same position and, the engines being
+    // deterministic, be the same game, so a few random moves are played first
+    if (options.randomPlies < 0)
+        options.randomPlies = options.openings.empty() ? 8 : 0;
+
+    std::vector<Opening> openings;
+    if (options.openings.empty()) {
+        openings.emplace_back();
+    } else if (!LoadOpenings(options.openings, openings) || openings.empty()) {
+        fmt::print(stderr, "no openings in '{}'\n", options.openings);
+        return 1;
+    } else {
+        // Each opening is played by one pair only, in an order of its own for every seed, so
+        // that a short run doesn't just cover the start of the file
+        std::mt19937_64 random{options.seed};
+        std::shuffle(openings.begin(), openings.end(), random);
+        if (options.games > openings.size() * 2) {
+            options.games = openings.size() * 2;
+            fmt::print(stderr,
+                       "'{}' has {} openings, playing at most {} games\n",
+                       options.openings,
+                       openings.size(),
+                       options.games);
+        }
+    }
+
+    std::FILE *output = nullptr;
+    if (!options.output.empty() && !(output = std::fopen(options.output.c_str(), "wb"))) {
+        fmt::print(stderr, "could not create '{}'\n", options.output);
+        return 1;
+    }
+
+    // The test stops once the ratio crosses either bound
+    const double lower = std::log(options.beta / (1 - options.alpha));
+    const double upper = std::log((1 - options.beta) / options.alpha);
+
+    // Each game slot plays whole pairs one after another, with a search of its own for each
+    // player, so memory grows with the slots and not with the games
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool>        stop{false};
+    std::mutex               mutex;
+    std::size_t              finished = 0, plies = 0;
+    std::size_t              results[3]{}, terminations[NONE]{};
+    std::uint64_t            nodes = 0;
+    Pentanomial              pairs;
+
+    const auto start    = std::chrono::steady_clock::now();
+    const auto total    = options.games / 2 + options.games % 2;
+    const auto threads  = std::min(options.concurrency, total);
+    const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    const auto cores    = std::min<std::size_t>(threads, hardware);
+
+    std::vector<std::thread> slots;
+    for (std::size_t i = 0; i < threads; i++) {
+        slots.emplace_back([&] {
+            xt::Search searches[2];
+            for (int player = 0; player < 2; player++) {
+                const auto &settings = options.players[player];
+                searches[player].SetHashSize(settings.hash ? settings.hash : options.hash);
+                searches[player].SetOptions(settings.options);
+            }
+
+            xt::GameRecorder recorder;
+            std::string      pgn;
+            for (std::size_t pair; !stop && (pair = next++) < total;) {
+                // A is white in the first game of the pair and black in the second
+                const auto     &line = openings[options.openings.empty() ? 0 : pair];
+                std::mt19937_64 random{options.seed + pair * 0x9E3779B97F4A7C15ull};
+                const auto      opening = AddRandomPlies(line, options.randomPlies, random);
+                int             score   = 0;
+                for (int second = 0; second < 2 && pair * 2 + second < options.games; second++) {
+                    const auto &white = options.players[second];
+                    const auto &black = options.players[!second];
+                    const auto  game  = Play(options,
+                                             opening,
+                                             searches[second],
+                                             searches[!second],
+                                             recorder);
+
+                    const int points = game.result == "1-0" ? 2 : game.result == "0-1" ? 0 : 1;
+                    score += second ? 2 - points : points;
+
+                    pgn.clear();
+                    if (output) {
+                        recorder.SetTag("Event", "selfplay");
+                        recorder.SetTag("Round", std::to_string(pair * 2 + second + 1));
+                        recorder.SetTag("White", white.name);
+                        recorder.SetTag("Black", black.name);
+                        recorder.SetResult(game.result);
+                        recorder.Write(pgn);
+                    }
+
+                    std::lock_guard lock{mutex};
+                    finished++;
+                    plies += game.plies;
+                    nodes += game.nodes;
+                    results[2 - points]++;
+                    terminations[game.termination]++;
+                    if (output)
+                        std::fwrite(pgn.data(), 1, pgn.size(), output);
+                    if (options.verbose)
+                        fmt::print("game {} {} - {} {} by {} in {} plies\n",
+                                   pair * 2 + second + 1,
+                                   white.name,
+                                   black.name,
+                                   game.result,
+                                   TERMINATIONS[game.termination],
+                                   game.plies);
+                }
+
+                // A pair cut short by the game limit says nothing about colour bias
+                if (pair * 2 + 1 >= options.games)
+                    continue;
+
+                std::lock_guard lock{mutex};
+                pairs.counts[score]++;
+                if (options.sprt) {
+                    const double llr = pairs.GetLlr(options.elo0, options.elo1);
+                    if (llr <= lower || llr >= upper)
+                        stop = true;
+                    if (options.verbose)
+                        fmt::print("pair {} LLR {:.2f} ({:.2f}, {:.2f})\n",
+                                   pairs.GetPairs(),
+                                   llr,
+                                   lower,
+                                   upper);
+                }
+            }
+        });
+    }
+
+    for (auto &slot : slots)
+        slot.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                               .count();
+    const double white = (results[0] + results[1] * 0.5) / finished;
+    fmt::print("{} games in {:.1f}s on {} slots with seed {}: +{} ={} -{} for white ({:.1f}%)\n",
+               finished,
+               seconds,
+               threads,
+               options.seed,
+               results[0],
+               results[1],
+               results[2],
+               white * 100);
+    for (int i = 0; i < NONE; i++)
+        if (terminations[i])
+            fmt::print("  {:<12} {}\n", TERMINATIONS[i], terminations[i]);
+
+    fmt::print("{:.1f} plies per game, {} nodes ({:.0f} nps), {:.0f} games per hour per core\n",
+               static_cast<double>(plies) / finished,
+               nodes,
+               nodes / std::max(seconds, 1e-9),
+               finished * 3600.0 / std::max(seconds, 1e-9) / cores);
+
+    if (pairs.GetPairs()) {
+        double mean, variance;
+        pairs.GetMoments(mean, variance);
+
+        // 95% confidence interval of A's score, as Elo
+        const double margin = 1.96 * std::sqrt(variance / pairs.GetPairs());
+        const double elo    = Pentanomial::GetElo(mean);
+        fmt::print("A vs B: {:.1f}% over {} pairs [{} {} {} {} {}], Elo {:+.1f} ({:+.1f}, "
+                   "{:+.1f})\n",
+                   mean * 100,
+                   pairs.GetPairs(),
+                   pairs.counts[0],
+                   pairs.counts[1],
+                   pairs.counts[2],
+                   pairs.counts[3],
+                   pairs.counts[4],
+                   elo,
+                   Pentanomial::GetElo(mean - margin),
+                   Pentanomial::GetElo(mean + margin));
+    }
+
+    if (options.sprt) {
+        const double llr = pairs.GetLlr(options.elo0, options.elo1);
+        fmt::print("SPRT elo0 {} elo1 {} alpha {} beta {}: LLR {:.2f} ({:.2f}, {:.2f}), {}\n",
+                   options.elo0,
+                   options.elo1,
+                   options.alpha,
+                   options.beta,
+                   llr,
+                   lower,
+                   upper,
+                   llr >= upper ? "H1 accepted" : llr <= lower ? "H0 accepted" : "inconclusive");
+    }
+
+    if (output && std::fclose(output) != 0) {
+        fmt::print(stderr, "could not write '{}'\n", options.output);
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
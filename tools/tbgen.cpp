@@ -0,0 +1,476 @@
+#include <fmt/format.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.hpp"
+#include "tablebase.hpp"
+
+namespace {
+    using xt::Piece;
+    using xt::Team;
+    using xt::Vector;
+
+    using xt::EndgameTable;
+    using xt::TableMaterial;
+
+    constexpr const std::uint8_t DRAW   = EndgameTable::DRAW;
+    constexpr const std::uint8_t BROKEN = EndgameTable::BROKEN;
+
+    // Best conversion for a position without any
+    constexpr const std::uint8_t NO_CONVERSION = 0xFF;
+
+    constexpr const int KING_OFFSETS[][2] = {
+        {-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+    constexpr const int KNIGHT_OFFSETS[][2] = {
+        {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    constexpr const int ROOK_DIRECTIONS[][2]   = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    constexpr const int BISHOP_DIRECTIONS[][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+    Team Opponent(Team team) {
+        return team == Team::WHITE ? Team::BLACK : Team::WHITE;
+    }
+
+    std::uint8_t Load(const std::uint8_t &value) {
+        return __atomic_load_n(&value, __ATOMIC_RELAXED);
+    }
+
+    bool TrySet(std::uint8_t &value, std::uint8_t from, std::uint8_t to) {
+        return __atomic_compare_exchange_n(
+            &value, &from, to, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+
+    // Value of board for the side to move from the finished tables, which hold every material
+    // it can convert into
+    std::uint8_t Probe(const xt::Tablebase &tables, const xt::Board &board) {
+        return *tables.Probe(board);
+    }
+
+    // Runs f(index, board) over [0, size) on every thread, each with a scratch board
+    template <typename F>
+    void ParallelFor(std::size_t size, std::size_t threads, F &&f) {
+        constexpr std::size_t CHUNK = 1 << 14;
+
+        std::atomic<std::size_t> next{0};
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < threads; i++) {
+            workers.emplace_back([&] {
+                xt::Board board;
+                for (std::size_t begin; (begin = next.fetch_add(CHUNK)) < size;)
+                    for (std::size_t index = begin; index < std::min(begin + CHUNK, size); index++)
+                        f(index, board);
+            });
+        }
+
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    // Retrograde analysis over one table. Mates and conversions into finished tables seed the
+    // search, then each pass settles the positions decided at the next ply: wins are found by
+    // unmoving from losses, and losses by unmoving from wins and checking every move forward.
+    // The distances to zeroing are found the same way once the distances to mate are known, with
+    // every capture, promotion and pawn move as a conversion.
+    class Generator {
+    public:
+        Generator(EndgameTable &table, const xt::Tablebase &tables, std::size_t threads)
+            : mTable(table), mTables(tables), mThreads(threads) { }
+
+        void Run() {
+            mTable.Allocate();
+            for (const bool zeroing : {false, true}) {
+                mZeroing = zeroing;
+                mValues  = zeroing ? mTable.GetDtzValues() : mTable.GetValues();
+                mConversions.assign(mTable.GetSize(), NO_CONVERSION);
+                mCandidates.assign(mTable.GetSize(), 0);
+
+                const int last = Initialize();
+                for (int plies = 1, idle = 0; idle < 2 || plies <= last; plies++) {
+                    const auto found = plies % 2 ? FindWins(plies) : FindLosses(plies);
+                    idle             = found ? 0 : idle + 1;
+                }
+            }
+
+            mConversions = {};
+            mCandidates  = {};
+        }
+
+    private:
+        bool Setup(xt::Board &board, std::size_t index) const {
+            EndgameTable::Squares squares;
+            const auto            turn = mTable.Decode(index, squares);
+
+            static thread_local std::vector<std::pair<Vector, Piece>> pieces;
+            pieces.clear();
+
+            const auto &types = mTable.GetPieces();
+            for (std::size_t i = 0; i < types.size(); i++) {
+                const int rank = squares[i] >> 3;
+                if (types[i].type == Piece::PAWN && (rank == 0 || rank == 7))
+                    return false;
+
+                for (std::size_t j = 0; j < i; j++)
+                    if (squares[i] == squares[j])
+                        return false;
+
+                pieces.push_back({Vector(squares[i] & 7, rank), types[i]});
+            }
+
+            return board.Setup(pieces, turn) &&
+                   !board.IsAttacked(board.GetKing(Opponent(turn)), turn);
+        }
+
+        static bool IsConversion(const xt::Board &board, const xt::Move &move) {
+            return move.promotion != Piece::MAX || board.IsCapture(move);
+        }
+
+        // Moves that reset the fifty-move counter
+        static bool IsZeroing(const xt::Board &board, const xt::Move &move) {
+            return IsConversion(board, move) || board[move.src].type == Piece::PAWN;
+        }
+
+        // Value of child, reached from board by move. The distance to zeroing stops at a zeroing
+        // move, leaving only who wins: the loser's move there counts as two plies rather than
+        // one, so the parity of the value still tells the side to move's result.
+        std::uint8_t GetChild(const xt::Board &board,
+                              const xt::Move  &move,
+                              const xt::Board &child) const {
+            if (mZeroing && !IsZeroing(board, move))
+                return Load(mValues[mTable.Locate(child, false)]);
+
+            const auto value =
+                IsConversion(board, move) ? Probe(mTables, child) : mTable.Probe(child, false);
+            if (!mZeroing || value == DRAW)
+                return value;
+            return EndgameTable::IsLoss(value) ? 1 : 2;
+        }
+
+        // Marks illegal positions and mates, and records the best conversion for the rest.
+        // Returns the longest distance a conversion settles a position at.
+        int Initialize() {
+            std::atomic<int> last{0};
+            ParallelFor(mTable.GetSize(), mThreads, [&](std::size_t index, xt::Board &board) {
+                if (!Setup(board, index)) {
+                    mValues[index] = BROKEN;
+                    return;
+                }
+
+                xt::MoveList moves;
+                board.GenerateMoves(moves);
+                if (moves.Empty()) {
+                    mValues[index] = board.InCheck() ? 1 : DRAW;
+                    return;
+                }
+
+                auto best = NO_CONVERSION;
+                for (const auto &move : moves) {
+                    if (!(mZeroing ? IsZeroing(board, move) : IsConversion(board, move)))
+                        continue;
+
+                    auto child = board;
+                    child.MakeMove(move);
+
+                    const auto value = EndgameTable::GetParent(GetChild(board, move, child));
+                    if (best == NO_CONVERSION ||
+                        EndgameTable::GetRank(value) > EndgameTable::GetRank(best))
+                        best = value;
+                }
+
+                mConversions[index] = best;
+                if (best != NO_CONVERSION && best != DRAW) {
+                    for (int prev = last; best - 1 > prev;)
+                        if (last.compare_exchange_weak(prev, best - 1))
+                            break;
+                }
+            });
+            return last;
+        }
+
+        // Calls f with the index of every position that reaches index with one move
+        template <typename F>
+        void ForEachUnmove(std::size_t index, F &&f) const {
+            EndgameTable::Squares squares;
+            const auto            turn  = mTable.Decode(index, squares);
+            const auto            mover = Opponent(turn);
+            const auto           &types = mTable.GetPieces();
+
+            std::uint64_t occupied = 0;
+            for (std::size_t i = 0; i < types.size(); i++)
+                occupied |= 1ull << squares[i];
+
+            const auto IsEmpty = [&](int x, int y) {
+                return x >= 0 && x < 8 && y >= 0 && y < 8 && !(occupied >> (y * 8 + x) & 1);
+            };
+
+            for (std::size_t i = 0; i < types.size(); i++) {
+                if (types[i].team != mover)
+                    continue;
+
+                const int  x = squares[i] & 7, y = squares[i] >> 3;
+                const auto From = [&](int fx, int fy) {
+                    auto prev = squares;
+                    prev[i]   = fy * 8 + fx;
+                    mTable.ForEachIndex(mover, prev, f);
+                };
+
+                const auto Step = [&](const int(&offsets)[8][2]) {
+                    for (const auto &offset : offsets)
+                        if (IsEmpty(x + offset[0], y + offset[1]))
+                            From(x + offset[0], y + offset[1]);
+                };
+
+                const auto Slide = [&](const int(&directions)[4][2]) {
+                    for (const auto &dir : directions)
+                        for (int fx = x + dir[0], fy = y + dir[1]; IsEmpty(fx, fy);
+                             fx += dir[0], fy += dir[1])
+                            From(fx, fy);
+                };
+
+                switch (types[i].type) {
+                case Piece::KING:
+                    Step(KING_OFFSETS);
+                    break;
+                case Piece::KNIGHT:
+                    Step(KNIGHT_OFFSETS);
+                    break;
+                case Piece::BISHOP:
+                    Slide(BISHOP_DIRECTIONS);
+                    break;
+                case Piece::ROOK:
+                    Slide(ROOK_DIRECTIONS);
+                    break;
+                case Piece::QUEEN:
+                    Slide(ROOK_DIRECTIONS);
+                    Slide(BISHOP_DIRECTIONS);
+                    break;
+                case Piece::PAWN:
+                {
+                    // White pawns advance towards y = 0
+                    const int back  = mover == Team::WHITE ? 1 : -1;
+                    const int start = mover == Team::WHITE ? 6 : 1;
+                    if (y + back == 0 || y + back == 7 || !IsEmpty(x, y + back))
+                        break;
+
+                    From(x, y + back);
+                    if (y + 2 * back == start && IsEmpty(x, start))
+                        From(x, start);
+                } break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        // Positions with a move to one lost in plies - 1 are won in plies
+        std::size_t FindWins(int plies) {
+            const auto               win = static_cast<std::uint8_t>(plies + 1);
+            std::atomic<std::size_t> found{0};
+            ParallelFor(mTable.GetSize(), mThreads, [&](std::size_t index, xt::Board &) {
+                const auto value = Load(mValues[index]);
+                if (value == plies) {
+                    ForEachUnmove(index, [&](std::size_t prev) {
+                        if (TrySet(mValues[prev], DRAW, win))
+                            found++;
+                    });
+                } else if (value == DRAW && mConversions[index] == win) {
+                    if (TrySet(mValues[index], DRAW, win))
+                        found++;
+                }
+            });
+            return found;
+        }
+
+        // Candidates are positions with a move to one won in plies - 1, or a conversion lost in
+        // plies. They are lost if every move loses, and the longest loss is plies.
+        std::size_t FindLosses(int plies) {
+            const auto               loss = static_cast<std::uint8_t>(plies + 1);
+            std::atomic<std::size_t> found{0};
+
+            // Gather the candidates first so each is only checked once
+            const auto Mark = [&](std::size_t index) {
+                const auto conversion = mConversions[index];
+                if (Load(mValues[index]) == DRAW &&
+                    (conversion == NO_CONVERSION || EndgameTable::IsLoss(conversion)))
+                    __atomic_store_n(&mCandidates[index], 1, __ATOMIC_RELAXED);
+            };
+
+            ParallelFor(mTable.GetSize(), mThreads, [&](std::size_t index, xt::Board &) {
+                const auto value = Load(mValues[index]);
+                if (value == plies)
+                    ForEachUnmove(index, Mark);
+                else if (value == DRAW && mConversions[index] == loss)
+                    Mark(index);
+            });
+
+            ParallelFor(mTable.GetSize(), mThreads, [&](std::size_t index, xt::Board &board) {
+                if (!mCandidates[index])
+                    return;
+
+                mCandidates[index] = 0;
+                Setup(board, index);
+
+                xt::MoveList moves;
+                board.GenerateMoves(moves);
+
+                int longest = 0;
+                for (const auto &move : moves) {
+                    auto child = board;
+                    child.MakeMove(move);
+
+                    const auto value = EndgameTable::GetParent(GetChild(board, move, child));
+                    if (!EndgameTable::IsLoss(value) || value > loss)
+                        return;
+                    longest = std::max<int>(longest, value);
+                }
+
+                if (longest == loss) {
+                    __atomic_store_n(&mValues[index], loss, __ATOMIC_RELAXED);
+                    found++;
+                }
+            });
+            return found;
+        }
+
+    private:
+        EndgameTable             &mTable;
+        const xt::Tablebase      &mTables;
+        std::size_t               mThreads;
+        bool                      mZeroing{false};
+        std::uint8_t             *mValues{nullptr};
+        std::vector<std::uint8_t> mConversions;
+        std::vector<std::uint8_t> mCandidates;
+    };
+
+    // Every material with 3 or 4 pieces in total, pawnless and fewer pieces first
+    std::vector<TableMaterial> GetAllMaterials() {
+        constexpr Piece::Type TYPES[] = {
+            Piece::QUEEN, Piece::ROOK, Piece::BISHOP, Piece::KNIGHT, Piece::PAWN};
+
+        std::vector<TableMaterial> result;
+        const auto                 Add = [&](TableMaterial material) {
+            material.Sort();
+            if (material.IsCanonical())
+                result.push_back(material);
+        };
+
+        for (std::size_t i = 0; i < std::size(TYPES); i++) {
+            Add({{{}, {TYPES[i]}}});
+            for (std::size_t j = i; j < std::size(TYPES); j++)
+                Add({{{}, {TYPES[i], TYPES[j]}}});
+            for (std::size_t j = 0; j < std::size(TYPES); j++)
+                Add({{{TYPES[j]}, {TYPES[i]}}});
+        }
+
+        std::stable_sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
+            return std::make_pair(a.GetCount(), a.GetPawns()) <
+                   std::make_pair(b.GetCount(), b.GetPawns());
+        });
+        return result;
+    }
+
+    long GetPeakRss() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024;
+    }
+
+    bool Build(const TableMaterial &material,
+               xt::Tablebase       &tables,
+               const std::string   &directory,
+               std::size_t          threads) {
+        if (tables.Find(material))
+            return true;
+
+        for (const auto &conversion : material.GetConversions())
+            if (!Build(conversion, tables, directory, threads))
+                return false;
+
+        const auto name  = material.GetName();
+        const auto path  = fmt::format("{}/{}.xtb", directory, name);
+        auto       table = std::make_unique<EndgameTable>(material);
+        if (table->Open(path)) {
+            fmt::print("{}: loaded from {}\n", name, path);
+            tables.Add(std::move(table));
+            return true;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        Generator{*table, tables, threads}.Run();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::size_t legal = 0, decisive = 0;
+        int         longest = 0, zeroing = 0;
+        for (std::size_t i = 0; i < table->GetSize(); i++) {
+            const auto value = table->Get(i);
+            legal += value != BROKEN;
+            if (value != BROKEN && value != DRAW) {
+                decisive++;
+                longest = std::max(longest, value - 1);
+                zeroing = std::max(zeroing, table->GetDtz(i) - 1);
+            }
+        }
+
+        fmt::print("{}: {} positions, {} legal, {} decisive, longest mate {} plies, longest "
+                   "zeroing {} plies, {:.2f}s, {:.0f} positions/s, peak RSS {} MB\n",
+                   name,
+                   table->GetSize(),
+                   legal,
+                   decisive,
+                   longest,
+                   zeroing,
+                   elapsed.count(),
+                   table->GetSize() / std::max(elapsed.count(), 1e-9),
+                   GetPeakRss());
+
+        // Reopen the saved file so finished tables are paged in on demand
+        if (!table->Save(path) || !table->Open(path)) {
+            fmt::print(stderr, "could not write '{}'\n", path);
+            return false;
+        }
+
+        tables.Add(std::move(table));
+        return true;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string                directory = "tables";
+    std::size_t                threads   = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<TableMaterial> materials;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (arg == "-t" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (TableMaterial material;
+                   TableMaterial::Parse(arg, material) && material.GetCount() > 2) {
+            materials.push_back(material.IsCanonical() ? material : material.Flipped());
+        } else {
+            fmt::print(stderr, "usage: {} [-o directory] [-t threads] [material...]\n", argv[0]);
+            fmt::print(stderr, "materials are named like KQvKR, all 3 and 4 piece tables by "
+                               "default\n");
+            return 1;
+        }
+    }
+
+    if (materials.empty())
+        materials = GetAllMaterials();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    xt::Tablebase tables;
+    for (const auto &material : materials)
+        if (!Build(material, tables, directory, threads))
+            return 1;
+    return 0;
+}
\ No newline at end of file